@@ -1,161 +1,1274 @@
-
 #include "RxBert.hpp"
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+
+// words per call into the bulk check kernels
+static const unsigned int checkBlockWords = 4096;
+// smallest piece a block is split into, shorter calls cost more than the
+// word at a time check
+static const unsigned int pieceMinWords = 512;
+
+// CLOCK_MONOTONIC in ns, the time base of events and wall clock metrics
+static uint64_t monotonicNs() {
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+// part of total that falls in done of span
+static uint64_t proRata( uint64_t total, uint64_t done, uint64_t span ) {
+    return (uint64_t) ((unsigned __int128) total * done / span);
+}
+
+// standard normal quantile, Acklam's rational approximation, relative
+// error under 1.2e-9
+static double normalQuantile( double p ) {
+    static const double a[] = { -3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                                1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00 };
+    static const double b[] = { -5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                                6.680131188771972e+01, -1.328068155288572e+01 };
+    static const double c[] = { -7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                                -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00 };
+    static const double d[] = { 7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                                3.754408661907416e+00 };
+    double q, r;
+    if ( p <= 0 ) {
+        return -HUGE_VAL;
+    }
+    if ( p >= 1 ) {
+        return HUGE_VAL;
+    }
+    if ( p < 0.02425 ) {
+        q = sqrt( -2 * log( p ) );
+        return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+               ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+    }
+    if ( p > 1 - 0.02425 ) {
+        return -normalQuantile( 1 - p );
+    }
+    q = p - 0.5;
+    r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+           (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+}
+
+// P(X <= k) for X Poisson with mean lambda
+static double poissonCdf( uint64_t k, double lambda ) {
+    double term = exp( -lambda ), sum = term;
+    uint64_t i;
+    for ( i = 1; i <= k; i++ ) {
+        term *= lambda / (double) i;
+        sum += term;
+    }
+    return sum;
+}
+
+// Clopper-Pearson bound on the expected error count for k errors seen,
+// in the Poisson limit that holds for any BER well below 1.  Exact for
+// up to 100 errors, past that the Wilson-Hilferty cube gives the chi
+// square quantile to better than 0.1%.  upper picks the side, z is the
+// normal quantile of the confidence.
+static double poissonBound( uint64_t k, double confidence, double z, int upper ) {
+    double lo = 0, hi, mid, a, t;
+    unsigned int i;
+    if ( !upper && (k == 0) ) {
+        return 0;
+    }
+    if ( k > 100 ) {
+        a = upper ? (double) k + 1 : (double) k;
+        t = 1 - 1 / (9 * a) + (upper ? z : -z) / (3 * sqrt( a ));
+        return a * t * t * t;
+    }
+    if ( upper && (k == 0) ) {
+        return -log( 1 - confidence );
+    }
+    hi = (double) k + 10 + 10 * sqrt( (double) k + 1 );
+    for ( i = 0; i < 100; i++ ) {
+        mid = (lo + hi) / 2;
+        // upper: P(X <= k) = 1 - confidence, lower: P(X >= k) = 1 - confidence
+        if ( upper ? (poissonCdf( k, mid ) > 1 - confidence) : (poissonCdf( k - 1, mid ) > confidence) ) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo + hi) / 2;
+}
+
+// one bertParallel() job, the buffer cut into chunks each counting its own
+// errors against the locked reference
+struct RxBertChunks {
+    const unsigned char *buffer;
+    const unsigned char *table;
+    unsigned int tableBytes;
+    unsigned int refIndex;      // table byte for the start of the buffer
+    uint64_t expect;            // pattern word for the start of the buffer
+    const BertPatternDesc *pattern;
+    unsigned int bitOrder;
+    unsigned int inverted;      // count the matching bits instead
+    unsigned int chunkBytes;
+    unsigned int windowBytes;   // syncloss window
+    unsigned int lossErrors;    // syncloss threshold
+    uint64_t errors[4 * 64];
+    uint64_t head[4 * 64];      // errors in the first and last window of the chunk
+    uint64_t tail[4 * 64];
+    unsigned char lost[4 * 64]; // a window inside the chunk is over the threshold
+};
+
+// point the reference at byte offset of the buffer, *index with a table and
+// *reg without
+static void seekSpan( RxBertChunks *job, unsigned int offset, unsigned int *index, uint64_t *reg ) {
+    if ( job->table != NULL ) {
+        *index = (unsigned int) ((job->refIndex + (uint64_t) offset) % job->tableBytes);
+    } else {
+        *reg = bertJumpWord( job->expect, bertJumpPoly( 8ULL * offset, job->pattern->order, job->pattern->tap ),
+                             job->pattern->order, job->pattern->tap );
+    }
+}
+
+// errors in n bytes of the buffer from offset, the reference is carried on
+// in *index with a table and in *reg without
+static uint64_t checkSpan( RxBertChunks *job, unsigned int offset, unsigned int n, unsigned int *index, uint64_t *reg ) {
+    uint64_t errors = 0;
+    unsigned int left = n, part;
+
+    if ( job->table != NULL ) {
+        while ( left != 0 ) {
+            part = job->tableBytes - *index;
+            if ( part > left ) {
+                part = left;
+            }
+            errors += bertDiffBits( job->buffer + offset, job->table + *index, part );
+            offset += part;
+            left -= part;
+            *index = (*index + part) % job->tableBytes;
+        }
+    } else {
+        errors = bertCheckWords( job->buffer + offset, n / 8, reg, job->pattern, job->bitOrder );
+    }
+    if ( job->inverted ) {
+        errors = 8ULL * n - errors;
+    }
+    return errors;
+}
+
+static void checkChunk( void *arg, unsigned int chunk ) {
+    RxBertChunks *job = (RxBertChunks *) arg;
+    unsigned int offset = chunk * job->chunkBytes, index = 0, back = 0, n;
+    uint64_t reg = 0, backReg = 0, sum;
+
+    seekSpan( job, offset, &index, &reg );
+    job->errors[chunk] = checkSpan( job, offset, job->chunkBytes, &index, &reg );
+    job->head[chunk] = 0;
+    job->tail[chunk] = 0;
+    job->lost[chunk] = 0;
+    if ( job->errors[chunk] == 0 ) {
+        return;
+    }
+
+    // the windows reaching back into the chunk before are settled by the
+    // caller from these
+    seekSpan( job, offset, &index, &reg );
+    job->head[chunk] = checkSpan( job, offset, job->windowBytes, &index, &reg );
+    seekSpan( job, offset + job->chunkBytes - job->windowBytes, &index, &reg );
+    job->tail[chunk] = checkSpan( job, offset + job->chunkBytes - job->windowBytes, job->windowBytes, &index, &reg );
+
+    // too many errors to rule out syncloss from the total, slide the window
+    // through the chunk a word at a time, a second reference following a
+    // window behind takes off the word leaving it
+    if ( job->errors[chunk] > job->lossErrors ) {
+        seekSpan( job, offset, &index, &reg );
+        seekSpan( job, offset, &back, &backReg );
+        for ( n = 0, sum = 0; n < job->chunkBytes; n += 8 ) {
+            sum += checkSpan( job, offset + n, 8, &index, &reg );
+            if ( n >= job->windowBytes ) {
+                sum -= checkSpan( job, offset + n - job->windowBytes, 8, &back, &backReg );
+            }
+            if ( sum > job->lossErrors ) {
+                job->lost[chunk] = 1;
+                break;
+            }
+        }
+    }
+}
 
 RxBert::RxBert( int _PN ) {
+    statsSeq = 0;
+    statsPage = NULL;
+    statsName = NULL;
+    threads = 0;
+    bitOrder = BERT_MSB_FIRST;
+    setFastLock( 0 );
+    setCorrelationLock( 0 );
+    setFlywheel( 0, 0 );
+    setSlipDetect( 0 );
+    eventFn = NULL;
+    eventArg = NULL;
+    eventRing = NULL;
+    setErrorLog( 0, 0 );
+    lossRing = NULL;
+    setSyncLoss( syncLossWindowBits, syncLossErrors );
     setPN( _PN );
+    metricsBase = BERT_METRICS_OFF;
+    setConfidenceMethod( BERT_CI_CLOPPER_PEARSON );
+    setBerTarget( 0, 0 );
+    setBerPrecision( 0, 0 );
     resetState();
+    setBerAlarm( 0, 0 );
 }
 
 RxBert::~RxBert() {
-    // null
+    delete [] eventRing;
+    delete [] lossRing;
+    setStatsPage( NULL, 0 );
 }
 
 // tell this object to check the next MessageBuffer worth of PN data
+// Sync acquisition runs a byte at a time.  Once synced the expected data
+// no longer depends on the input, so whole 64 bit words of the buffer are
+// compared against the generated reference and the errors counted with a
+// single popcount per word.
+// The input does not have to be byte aligned to the pattern.  A PN stream
+// started k bits late is the same stream at another phase, so acquisition
+// loads that phase into the register and locks on any of the 8 bit
+// alignments without trying them separately, and the locked reference
+// follows the data at that offset without re-packing the buffer.
 void RxBert::check( unsigned char *buffer, unsigned int bytes ) {
 
-    unsigned int offset;
-    unsigned int RegA, RegB, FeedBack, errors;
-    unsigned char FeedIn;
-    for ( offset = 0; offset < bytes; offset++) {
-
-        bitsRX = bitsRX+8;
-        FeedIn = buffer[offset]; // byte that being feed in
-        
-        // compute feedback for current register value
-        switch (PN) {
-            case BERT_PN11:
-                ///// process for doing a PN11
-                // get the current byte
-                Reg = Reg & 0x7ff; // mask shift register
-                RegA = (Reg & 0x000000FF);  // mask first 8 feed back tap 1
-                RegB = (Reg & 0x000003FC) >> 2;  // mask second 8 feed back tap 2
-                FeedBack = (RegA) ^ (RegB);
-                break;
-            case BERT_PN15:
-                ////// process for doing a PN15 pattern
-                Reg = Reg & 0x7FFF;
-                RegA = (Reg & 0x000000FF); // mask first 8 states for feedback tap 1
-                RegB = (Reg & 0x000001FE) >> 1; // mask first 8 states for feedback tap 2
-                FeedBack = (RegB) ^ (RegA);
-                break;
-            case BERT_PN23:
-                ///// process for doing a PN23
-                Reg = Reg & 0x7FFFFF;
-                RegA = (Reg & 0x000000FF);  // mask first 8 feed back tap 1
-                RegB = (Reg & 0x00001FE0) >> 5;  // mask second 8 feed back tap 2
-                FeedBack = (RegB)^(RegA);
-                break;    
-            default:
-                break;
+    unsigned int offset = 0;
+    while ( offset < bytes ) {
+        if ( isSynced && (bytes - offset >= 8) ) {
+            // finish the word in progress, the worker pool starts on a new one
+            while ( isSynced && (wordBytes != 0) && (offset < bytes) ) {
+                checkByte( buffer[offset] );
+                offset++;
+            }
+            offset += checkParallel( buffer + offset, bytes - offset );
+            offset += checkSynced( buffer + offset, bytes - offset );
+            if ( isSynced && (bytes - offset >= 8) ) {
+                offset += checkWord( buffer + offset );
+            }
+        } else {
+            checkByte( buffer[offset] );
+            offset++;
+        }
+    }
+    if ( burstOpen && (bitsRX - burstEnd >= burstGap) ) {
+        closeBurst();
+    }
+    checkBerAlarm();
+    updateMetrics();
+    checkVerdict();
+    publishStats();
+}
+
+// locked path for very large buffers.  Rounds of chunks are checked on the
+// worker pool, then taken in order up to the first chunk that could have
+// a window over the threshold, which and everything after it is left to
+// the serial code.  A chunk settles the windows inside it itself, those
+// reaching back into the chunk before are bounded by that chunk's last
+// window and this one's first.
+// Returns the number of bytes used, 0 if the buffer is too small to split.
+unsigned int RxBert::checkParallel( unsigned char *buffer, unsigned int bytes ) {
+
+    RxBertChunks job;
+    unsigned int threads = bertThreadCount( this->threads ), offset = 0, chunks, accepted, c;
+    uint64_t before, errors;
+
+    if ( (threads <= 1) || (order == 0) || !isSynced || (wordBytes != 0) ||
+         (lossWindowBytes > BERT_PARALLEL_CHUNK) || (bitsRX < parallelResume) ) {
+        return 0;
+    }
+
+    job.chunkBytes = BERT_PARALLEL_CHUNK;
+    job.windowBytes = lossWindowBytes;
+    job.lossErrors = lossErrors;
+    while ( (bytes - offset) / job.chunkBytes >= 2 ) {
+        chunks = (bytes - offset) / job.chunkBytes;
+        if ( chunks > 4 * threads ) {
+            chunks = 4 * threads;
+        }
+        job.buffer = buffer + offset;
+        job.table = refValid ? table : NULL;
+        job.tableBytes = tableBytes;
+        job.refIndex = refIndex;
+        job.expect = bertNextWord( Reg, order, tap );
+        job.pattern = pattern;
+        job.bitOrder = bitOrder;
+        job.inverted = (polarityMask != 0);
+        bertParallel( chunks, checkChunk, &job, threads );
+
+        accepted = 0;
+        errors = 0;
+        before = windowErrors;
+        for ( c = 0; (c < chunks) && !job.lost[c] && (before + job.head[c] <= lossErrors); c++ ) {
+            if ( (job.errors[c] != 0) && errorDetail ) {
+                logBlock( job.buffer + accepted, job.chunkBytes,
+                          bertJumpWord( Reg, bertJumpPoly( 8ULL * accepted, order, tap ), order, tap ),
+                          bitsRX + 8ULL * accepted );
+            }
+            errors += job.errors[c];
+            before = job.tail[c];
+            accepted += job.chunkBytes;
+        }
+
+        bitErrors += errors;
+        slideBlock( job.buffer, accepted, errors, Reg );
+        Reg = bertJumpWord( Reg, bertJumpPoly( 8ULL * accepted, order, tap ), order, tap );
+        advanceRef( accepted );
+        bitsRX = bitsRX + 8ULL * accepted;
+        bitsRXinSync = bitsRXinSync + 8ULL * accepted;
+        offset += accepted;
+
+        if ( c < chunks ) {
+            // stay serial for a round's worth of data so a burst of errors
+            // does not throw away a round of work on every relock
+            parallelResume = bitsRX + 8ULL * chunks * job.chunkBytes;
+            break;
         }
+    }
+    return offset;
+}
+
+// locked fast path.  The buffer is compared in blocks, against the period
+// table when there is one and with the vector kernels otherwise.  A block
+// whose errors can not take the window in progress past the threshold,
+// even with all of them landing in the one window, can not declare
+// syncloss anywhere inside it, so its total is all that is needed and
+// only the words still in the window after it are counted again.  Any
+// other block is looked at again in pieces expected to hold a quarter of
+// the threshold each, so a steady error rate well under it stays in bulk.
+// A piece that could still get there, or a block that would only split
+// into pieces too short for the kernels, goes a word at a time with the
+// window tracked exactly.  Returns the number of bytes used.
+unsigned int RxBert::checkSynced( unsigned char *buffer, unsigned int bytes ) {
 
-        
-        // swap bit order of FeedIn
-        FeedIn = ((FeedIn * 0x80200802ULL) & 0x0884422110ULL) * 0x0101010101ULL >> 32;
+    uint64_t FeedBack;
+    unsigned int offset = 0, n, errors, end, limit = 8 * checkBlockWords, splitEnd = 0, piece;
 
-        // debug
-        //printf("debug: Sync = %d offset = %03d Reg = %08X FeedIn = %02X FeedBack = %02X syncWieght = %d\n"
-        //        , isSynced, offset, Reg, FeedIn, FeedBack, syncWieght );
+    while ( isSynced && (order != 0) && (bytes - offset >= 8) ) {
+        if ( offset >= splitEnd ) {
+            limit = 8 * checkBlockWords;
+        }
+        if ( refValid ) {
+            n = tableBytes - refIndex;
+            if ( n > limit ) {
+                n = limit;
+            }
+        } else {
+            // the kernels go a word at a time, so the window has to as well
+            if ( wordBytes != 0 ) {
+                checkByte( buffer[offset] );
+                offset++;
+                continue;
+            }
+            n = limit;
+        }
+        if ( n > bytes - offset ) {
+            n = refValid ? bytes - offset : (bytes - offset) & ~7U;
+        }
 
-        if ( isSynced == 0 ) {
-            // not synced
-            windowBytes = 0;
+        if ( refValid ) {
+            errors = (unsigned int) bertDiffBits( buffer + offset, table + refIndex, n );
+        } else {
+            FeedBack = bertNextWord( Reg, order, tap );
+            errors = (unsigned int) bertCheckWords( buffer + offset, n / 8, &FeedBack, pattern, bitOrder );
+        }
+        if ( polarityMask ) {
+            errors = 8 * n - errors;
+        }
 
-            // see if FeedBack matches FeedIn
-            if (FeedBack == FeedIn) {
-                //printf("Matched..\n");
-                // syncWieght increment
-                syncWieght++;
-                if ( syncWieght > 10 ) {
-                    // declare lock, got 80 bits in a row matching
-                    isSynced = 1;
-                    syncWieght = 0;
+        if ( windowErrors + wordErrors + errors > lossErrors ) {
+            // a window in this block could declare syncloss
+            piece = (errors != 0) ? (unsigned int) ((uint64_t) n * (lossErrors + 1) / (4ULL * errors)) & ~7U : 0;
+            if ( (piece >= 8 * pieceMinWords) && (piece > lossWindowBytes) && (piece < n) ) {
+                limit = piece;
+                if ( offset + n > splitEnd ) {
+                    splitEnd = offset + n;
                 }
-            } else {
-                // reset sync Wieght
+                continue;
+            }
+            end = offset + n;
+            for ( ; isSynced && (wordBytes != 0) && (offset < end); offset++ ) {
+                checkByte( buffer[offset] );
+            }
+            if ( isSynced ) {
+                offset += slideWords( buffer + offset, (end - offset) & ~7U );
+            }
+            for ( ; isSynced && (offset < end); offset++ ) {
+                checkByte( buffer[offset] );
+            }
+            continue;
+        }
+
+        if ( (errors != 0) && errorDetail ) {
+            logBlock( buffer + offset, n, Reg, bitsRX );
+        }
+        bitErrors += errors;
+        slideBlock( buffer + offset, n, errors, Reg );
+        bitsRX = bitsRX + 8 * n;
+        bitsRXinSync = bitsRXinSync + 8 * n;
+        offset += n;
+
+        if ( refValid ) {
+            refIndex = (refIndex + n) % tableBytes;
+            tableReg( n );
+        } else {
+            Reg = bertJumpWord( Reg, (n == 8 * checkBlockWords) ? blockJump : bertJumpPoly( 8ULL * n, order, tap ),
+                                order, tap );
+        }
+    }
+    return offset;
+}
+
+// the words of a block that could declare syncloss, from a window word
+// boundary.  Each word is compared against the table, or the register
+// stepped a word at a time, and its errors go straight into the window,
+// up to the word that takes it over the threshold.  Returns the number of
+// bytes used.
+unsigned int RxBert::slideWords( unsigned char *buffer, unsigned int bytes ) {
+
+    uint64_t next = Reg, diff, errors = 0, clean = 0;
+    unsigned int n, lost = 0, e;
+
+    for ( n = 0; (n < bytes) && !lost; n += 8 ) {
+        if ( refValid ) {
+            // the pad after the table covers a word running off its end,
+            // and the polarity mask reads the same in either bit order
+            diff = bertLoad64( buffer + n ) ^ bertLoad64( table + refIndex + n ) ^ polarityMask;
+        } else {
+            next = bertNextWord( next, order, tap );
+            diff = bertLoad64( buffer + n ) ^ bertWireWord( expect( next ), bitOrder );
+        }
+        if ( diff == 0 ) {
+            clean++;
+            continue;
+        }
+        diff = bertWireWord( diff, bitOrder );
+        if ( errorDetail ) {
+            logErrors( bitsRX + 8ULL * n, diff );
+        }
+        e = __builtin_popcountll( diff );
+        errors += e;
+        slideClean( clean );
+        clean = 0;
+        lost = slideWindow( e );
+    }
+    slideClean( clean );
+
+    bitErrors += errors;
+    bitsRX = bitsRX + 8ULL * n;
+    bitsRXinSync = bitsRXinSync + 8ULL * n;
+    if ( refValid ) {
+        refIndex = (refIndex + n) % tableBytes;
+        tableReg( n );
+    } else {
+        Reg = next;
+    }
+    if ( lost ) {
+        //declare syncloss
+        isSynced = 0;
+        syncLost();
+    }
+    return n;
+}
+
+// pick the register back up from the 8 table bytes before refIndex, after
+// bytes checked against the table.  The pad after the table covers a
+// refIndex near the start.  A zero suppressed table has forced ones in it,
+// that register is jumped.
+void RxBert::tableReg( unsigned int bytes ) {
+    unsigned int n;
+    if ( !pattern->zeroSuppress ) {
+        n = (refIndex >= 8) ? refIndex - 8 : refIndex + tableBytes - 8;
+        Reg = bertWireWord( bertLoad64( table + n ), bitOrder ) ^ pattern->invert;
+    } else {
+        Reg = bertJumpWord( Reg, bertJumpPoly( 8ULL * bytes, order, tap ), order, tap );
+    }
+}
+
+// check one byte, used while acquiring sync and for the ends of a buffer
+void RxBert::checkByte( unsigned char byteIn ) {
+
+    unsigned int errors;
+    uint64_t FeedIn, FeedBack, Expected;
+
+    bitsRX = bitsRX+8;
+
+    // swap bit order of FeedIn, LSB first bytes are already in stream order
+    if ( bitOrder == BERT_MSB_FIRST ) {
+        FeedIn = (uint64_t) (unsigned char) ( ((byteIn * 0x80200802ULL) & 0x0884422110ULL) * 0x0101010101ULL >> 32 );
+    } else {
+        FeedIn = byteIn;
+    }
+
+    if ( isSynced == 0 ) {
+        if ( outage ) {
+            outageBits = outageBits + 8;
+        }
+        if ( flyActive && flywheelByte( FeedIn ) ) {
+            return;
+        }
+    }
+    if ( (isSynced == 0) && autoDetect ) {
+        acquireAuto( FeedIn );
+        return;
+    }
+    if ( (isSynced == 0) && (correlateBits != 0) && (order != 0) ) {
+        acquireCorrelate( FeedIn );
+        return;
+    }
+
+    // compute feedback for current register value, and the bits that
+    // should be on the wire for it
+    FeedBack = predict();
+    Expected = expect( FeedBack ) & 0xFF;
+    FeedBack = FeedBack & 0xFF;
+
+    // debug
+    //printf("debug: Sync = %d Reg = %016llX FeedIn = %02X FeedBack = %02X syncWieght = %d\n"
+    //        , isSynced, Reg, FeedIn, FeedBack, syncWieght );
+
+    if ( isSynced == 0 ) {
+        // not synced
+        // see if FeedBack matches FeedIn
+        if (Expected == FeedIn) {
+            // syncWieght increment
+            syncWieght++;
+            if ( syncWieght >= (int) lockBytes ) {
+                // declare lock, got lockBytes bytes in a row matching
+                isSynced = 1;
                 syncWieght = 0;
             }
-      
-            switch (PN) {
-                case BERT_PN11:
-                    // shift up register length, add to top of shif tregister
-                    Reg = Reg + ( FeedIn << 11);
-                    break;
-                case BERT_PN15:
-                    // shift up register length, add to top of shif tregister
-                    Reg = Reg + (FeedIn << 15);
-                    break;
-                case BERT_PN23:
-                    // shift up register length, add to top of shif tregister
-                    Reg = Reg + ( FeedIn << 23);
-                    break;
+        } else if ( (order != 0) && (FeedIn == (expectFlipped() & 0xFF)) ) {
+            // matches the complemented stream, carry on acquiring with the
+            // other polarity, the register flipped to match
+            polarityMask = ~polarityMask;
+            Reg = ~Reg;
+            syncWieght = 1;
+            if ( syncWieght >= (int) lockBytes ) {
+                isSynced = 1;
+                syncWieght = 0;
+            }
+        } else {
+            // reset sync Wieght
+            syncWieght = 0;
+        }
+
+        // shift the received byte into the register, as raw pattern bits
+        // for the polarity being acquired
+        if ( pattern != NULL ) {
+            FeedIn = FeedIn ^ ((pattern->invert ^ polarityMask) & 0xFF);
+        }
+        Reg = (Reg >> 8) | (FeedIn << 56);
+        if ( isSynced ) {
+            syncAcquired( 1.0 );
+        }
+
+    } else {
+        // are synced
+        bitsRXinSync = bitsRXinSync + 8;
+        // and feedIn XOR FeedBack with give back a register of differenced bits
+        // pop_count counts the number of bits that are set after the operation.
+        // this is the number of errors in this 8 bit check
+        // popcount is a built in function that translates to fast assembly
+        // this method only exists in GCC. if you use another compiler, you will
+        // need to invent your own.
+        errors = __builtin_popcount ( (unsigned int) (FeedIn ^ Expected) );
+        if ( (errors != 0) && errorDetail ) {
+            logErrors( bitsRX - 8, FeedIn ^ Expected );
+        }
+        bitErrors += errors;
+        wordErrors += errors;
+        wordBytes++;
+        if ( wordBytes == 8 ) {
+            if ( slideWindow( wordErrors ) ) {
+                //declare syncloss
+                isSynced = 0;
+            }
+            wordBytes = 0;
+            wordErrors = 0;
+        }
+
+        // perform sycned feedback to shift register input
+        Reg = (Reg >> 8) | (FeedBack << 56);
+        advanceRef( 1 );
+        if ( !isSynced ) {
+            syncLost();
+        }
+    }
+}
+
+// check 8 bytes while synced, tracking the syncloss window byte by byte.
+// Returns the number of bytes used, which is 8 unless the syncloss check
+// fires on a window word that ends part way through them.
+unsigned int RxBert::checkWord( unsigned char *buffer ) {
+
+    unsigned int used = 8, boundary, errors;
+    uint64_t FeedIn, FeedBack, diff, head;
+
+    FeedBack = predict();
+    FeedIn = bertWireWord( bertLoad64( buffer ), bitOrder );
+    diff = FeedIn ^ expect( FeedBack );
+
+    // bytes to the end of the word the syncloss window is waiting on, the
+    // rest start the next one
+    boundary = 8 - wordBytes;
+    head = diff & (0xFFFFFFFFFFFFFFFFULL >> (64 - 8 * boundary));
+    errors = __builtin_popcountll( head );
+    bitErrors += errors;
+    if ( slideWindow( wordErrors + errors ) ) {
+        //declare syncloss, the rest of the word goes back through acquisition
+        isSynced = 0;
+        used = boundary;
+        wordErrors = 0;
+    } else {
+        errors = __builtin_popcountll( diff ^ head );
+        bitErrors += errors;
+        wordErrors = errors;
+    }
+    wordBytes = (used == 8) ? 8 - boundary : 0;
+
+    // only the bytes used, the head of the word may be clean when syncloss
+    // cut it short
+    if ( used != 8 ) {
+        diff &= (1ULL << (8 * used)) - 1;
+    }
+    if ( (diff != 0) && errorDetail ) {
+        logErrors( bitsRX, diff );
+    }
+    bitsRX = bitsRX + 8 * used;
+    bitsRXinSync = bitsRXinSync + 8 * used;
+
+    // perform sycned feedback to shift register input
+    if ( used == 8 ) {
+        Reg = FeedBack;
+    } else {
+        Reg = (Reg >> (8 * used)) | (FeedBack << (64 - 8 * used));
+    }
+    advanceRef( used );
+    if ( !isSynced ) {
+        syncLost();
+    }
+    return used;
+}
+
+// one more whole word into the syncloss window with errors in it, the
+// oldest leaves.  Returns 1 if the window is then over the threshold.
+unsigned int RxBert::slideWindow( unsigned int errors ) {
+    lossWords++;
+    if ( (lossUsed != 0) && (lossRing[lossHead].word + lossWindowBytes / 8 < lossWords) ) {
+        windowErrors -= lossRing[lossHead].errors;
+        lossHead = (lossHead + 1) & (lossRingSize - 1);
+        lossUsed--;
+    }
+    if ( errors != 0 ) {
+        lossRing[(lossHead + lossUsed) & (lossRingSize - 1)].word = lossWords - 1;
+        lossRing[(lossHead + lossUsed) & (lossRingSize - 1)].errors = errors;
+        lossUsed++;
+        windowErrors += errors;
+    }
+    return windowErrors > lossErrors;
+}
+
+// words more of the syncloss window without errors
+void RxBert::slideClean( uint64_t words ) {
+    lossWords = lossWords + words;
+    while ( (lossUsed != 0) && (lossRing[lossHead].word + lossWindowBytes / 8 < lossWords) ) {
+        windowErrors -= lossRing[lossHead].errors;
+        lossHead = (lossHead + 1) & (lossRingSize - 1);
+        lossUsed--;
+    }
+}
+
+// bring the syncloss window to the end of bytes checked in bulk, errors
+// in them in all, that can not have taken it over the threshold.  reg is
+// the register at their start.  Only the words still in the window at the
+// end want counting again, the rest go through as clean.
+void RxBert::slideBlock( const unsigned char *buffer, unsigned int bytes, uint64_t errors, uint64_t reg ) {
+    uint64_t words = (wordBytes + bytes) / 8, window = lossWindowBytes / 8, next, diff;
+    unsigned char last[8];
+    unsigned int n = 0, part;
+
+    if ( words == 0 ) {
+        wordBytes += bytes;
+        wordErrors += (unsigned int) errors;
+        return;
+    }
+    if ( (errors == 0) || (words > window) ) {
+        slideWindow( (errors == 0) ? wordErrors : 0 );
+        slideClean( (errors == 0) ? words - 1 : words - window - 1 );
+        wordErrors = 0;
+        if ( errors == 0 ) {
+            wordBytes = (wordBytes + bytes) % 8;
+            return;
+        }
+        n = (unsigned int) (8 * (words - window) - wordBytes);
+        wordBytes = 0;
+        reg = bertJumpWord( reg, bertJumpPoly( 8ULL * n, order, tap ), order, tap );
+    }
+
+    // a window word at a time, the last one may be left part done
+    for ( ; n < bytes; n += part ) {
+        part = 8 - wordBytes;
+        if ( part > bytes - n ) {
+            part = bytes - n;
+        }
+        next = bertNextWord( reg, order, tap );
+        memset( last, 0, sizeof(last) );
+        memcpy( last, buffer + n, part );
+        diff = bertWireWord( bertLoad64( last ), bitOrder ) ^ expect( next );
+        if ( part != 8 ) {
+            diff &= (1ULL << (8 * part)) - 1;
+            reg = (reg >> (8 * part)) | (next << (64 - 8 * part));
+        } else {
+            reg = next;
+        }
+        wordErrors += __builtin_popcountll( diff );
+        wordBytes += part;
+        if ( wordBytes == 8 ) {
+            slideWindow( wordErrors );
+            wordBytes = 0;
+            wordErrors = 0;
+        }
+    }
+}
+
+// start the syncloss window over
+void RxBert::clearWindow() {
+    wordBytes = 0;
+    wordErrors = 0;
+    windowErrors = 0;
+    lossWords = 0;
+    lossHead = 0;
+    lossUsed = 0;
+}
+
+// log the errors in bytes of the buffer checked in bulk, reg is the raw
+// pattern word before them and position the bitsRX of the first byte.
+// Only blocks the kernels found errors in come here, so an error free
+// stream never pays for the log.
+void RxBert::logBlock( const unsigned char *buffer, unsigned int bytes, uint64_t reg, uint64_t position ) {
+    unsigned char last[8];
+    uint64_t diff;
+    unsigned int n, left;
+
+    for ( n = 0; n < bytes; n += 8 ) {
+        reg = bertNextWord( reg, order, tap );
+        left = bytes - n;
+        if ( left >= 8 ) {
+            diff = bertWireWord( bertLoad64( buffer + n ), bitOrder ) ^ expect( reg );
+        } else {
+            memset( last, 0, sizeof(last) );
+            memcpy( last, buffer + n, left );
+            diff = (bertWireWord( bertLoad64( last ), bitOrder ) ^ expect( reg )) & ((1ULL << (8 * left)) - 1);
+        }
+        if ( diff != 0 ) {
+            logErrors( position + 8ULL * n, diff );
+        }
+    }
+}
+
+// add a word with errors to the event ring and its errors to the bursts.
+// The gap rule goes bit by bit, so a word can hold the end of one burst
+// and the start of the next.
+// Single writer: the slot is filled before eventHead moves past it, and the
+// fence keeps those stores after the eventHead that lets a reader see the
+// slot is being reused.
+void RxBert::logErrors( uint64_t position, uint64_t diff ) {
+    uint64_t bits = diff, bit;
+    BertErrorEvent *e;
+
+    if ( diff == 0 ) {
+        return;
+    }
+    while ( bits != 0 ) {
+        bit = position + __builtin_ctzll( bits );
+        bits &= bits - 1;
+        if ( burstOpen && (bit - burstEnd >= burstGap) ) {
+            closeBurst();
+        }
+        if ( !burstOpen ) {
+            burstOpen = 1;
+            burstStart = bit;
+            fireEvent( BERT_EVENT_BURST_START, bit, 0 );
+        }
+        burstEnd = bit;
+    }
+    if ( eventRing == NULL ) {
+        return;
+    }
+
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+    e = &eventRing[eventHead & (eventSize - 1)];
+    e->bitOffset = position;
+    e->mask = diff;
+    e->run = burstEnd - burstStart + 1;
+    __atomic_store_n( &eventHead, eventHead + 1, __ATOMIC_RELEASE );
+}
+
+void RxBert::closeBurst() {
+    uint64_t length = burstEnd - burstStart + 1;
+    unsigned int bin = 63 - __builtin_clzll( length );
+    burstHistogram[(bin < burstBins) ? bin : burstBins - 1]++;
+    burstCount++;
+    burstOpen = 0;
+    fireEvent( BERT_EVENT_BURST_END, burstEnd + 1, (double) length );
+}
+
+void RxBert::fireEvent( unsigned int type, uint64_t position, double value ) {
+    BertEvent e;
+    if ( eventFn == NULL ) {
+        return;
+    }
+    e.type = type;
+    e.time = monotonicNs();
+    e.bitPosition = position;
+    e.value = value;
+    eventFn( eventArg, &e );
+}
+
+// once a window of berWindowBits synced bits is in, raise or clear the
+// alarm on its BER and start the next one
+void RxBert::checkBerAlarm() {
+    double ber;
+    if ( (berThreshold <= 0) || (bitsRXinSync - berStartBits < berWindowBits) ) {
+        return;
+    }
+    ber = (double) (bitErrors - berStartErrors) / (double) (bitsRXinSync - berStartBits);
+    if ( !berAlarm && (ber > berThreshold) ) {
+        berAlarm = 1;
+        fireEvent( BERT_EVENT_BER_ALARM, bitsRX, ber );
+    } else if ( berAlarm && (ber <= berThreshold) ) {
+        berAlarm = 0;
+        fireEvent( BERT_EVENT_BER_CLEAR, bitsRX, ber );
+    }
+    berStartBits = bitsRXinSync;
+    berStartErrors = bitErrors;
+}
+
+// sync declared by any of the acquisition paths, Reg is the raw pattern
+// register for the next byte
+void RxBert::syncAcquired( double confidence ) {
+    if ( lossPending ) {
+        // found again, but not as a slip
+        syncLossCount++;
+        lossPending = 0;
+    }
+    isSynced = 1;
+    syncWieght = 0;
+    syncConfidence = confidence;
+    clearWindow();
+    outage = 0;
+    flyActive = 0;
+    locateRef();
+    fireEvent( BERT_EVENT_SYNC, bitsRX, confidence );
+}
+
+// sync just dropped, Reg is still the reference for the next byte.  The
+// flywheel carries it on through the outage.  With slip detection on, the
+// syncloss is only counted once the flywheel has had slipHuntBytes to
+// find the data again at a slip.
+void RxBert::syncLost() {
+    outage = 1;
+    // syncloss fires at the end of a window word, bitsRX is there
+    lossStart = bitsRX;
+    if ( lossUsed != 0 ) {
+        lossStart = bitsRX - 64ULL * (lossWords - lossRing[lossHead].word);
+    }
+    if ( (flywheel || slipMax) && (order != 0) ) {
+        flyActive = 1;
+        flyReg = Reg;
+        flyPolarity = polarityMask;
+        flyRange = flywheel ? flySlip : 0;
+        if ( flyRange < slipMax ) {
+            flyRange = slipMax;
+        }
+        flyBytes = 0;
+        memset( flyWeight, 0, sizeof(flyWeight) );
+    }
+    if ( slipMax && (order != 0) ) {
+        lossPending = 1;
+    } else {
+        syncLossCount++;
+    }
+    fireEvent( BERT_EVENT_SYNCLOSS, bitsRX, 0 );
+}
+
+// bytes the slip detector waits for the data to come back at a slip
+unsigned int RxBert::slipHuntBytes() {
+    return 2 * lossWindowBytes + lockBytes;
+}
+
+// flywheel.  Through an outage the reference keeps moving a byte for every
+// byte received, as if still synced, and each byte is compared against it
+// shifted by every slip of up to flyRange bits either way.  A slip that
+// matches lockBytes bytes in a row brings sync straight back at that
+// offset, a fade with no slip in it takes no longer than the check.  The
+// cold acquisition runs alongside for anything the flywheel can not pick
+// up.  Returns 1 once sync is back.
+unsigned int RxBert::flywheelByte( uint64_t FeedIn ) {
+    uint64_t next = bertNextWord( flyReg, order, tap ), Expected, period = (1ULL << order) - 1;
+    unsigned __int128 both = ((unsigned __int128) next << 64) | flyReg;
+    unsigned int n, found = 0;
+    int slip, foundSlip = 0;
+
+    // bit 64 of both is the next expected bit, data running slip bits
+    // late wants the bits from slip before it
+    for ( slip = -(int) flyRange, n = 0; slip <= (int) flyRange; slip++, n++ ) {
+        Expected = bertOutputWord( (uint64_t) (both >> (64 - slip)), pattern ) ^ flyPolarity;
+        if ( (Expected & 0xFF) == FeedIn ) {
+            flyWeight[n]++;
+            if ( !found && (flyWeight[n] >= lockBytes) ) {
+                found = 1;
+                foundSlip = slip;
             }
-            
         } else {
-            // are synced
-            bitsRXinSync = bitsRXinSync + 8;
-            // and feedIn XOR FeedBack with give back a register of differenced bits
-            // pop_count counts the number of bits that are set after the operation.
-            // this is the number of errors in this 8 bit check
-            // popcount is a built in function that translates to fast assembly
-            // this method only exists in GCC. if you use another compiler, you will
-            // need to invent your own.
-            errors = __builtin_popcount ( FeedIn ^ FeedBack );
-            bitErrors += errors;
-            windowErrors += errors;
-            if ( windowBytes > 10 ) {
-                windowBytes = 0;
-                if ( windowErrors > 20 ) { /* 25% */
-                    //declare syncloss
-                    isSynced = 0;
-                    syncLossCount++;
+            flyWeight[n] = 0;
+        }
+    }
+    flyReg = (flyReg >> 8) | (next << 56);
+    flyBytes++;
+    if ( !found ) {
+        if ( lossPending && (flyBytes >= slipHuntBytes()) ) {
+            // not a slip, a real syncloss
+            syncLossCount++;
+            lossPending = 0;
+            flyActive = flywheel;
+            flyRange = flySlip;
+            memset( flyWeight, 0, sizeof(flyWeight) );
+        }
+        return 0;
+    }
+
+    if ( lossPending && (foundSlip != 0) ) {
+        // a slip, not a syncloss.  The window that fired has the start of
+        // it, at the first word with errors in it unless errors from before
+        // the slip were still in the window.
+        if ( foundSlip > 0 ) {
+            insertions++;
+            insertedBits = insertedBits + (unsigned long) foundSlip;
+        } else {
+            deletions++;
+            deletedBits = deletedBits + (unsigned long) -foundSlip;
+        }
+        lastSlipPosition = lossStart;
+        lossPending = 0;
+    }
+
+    // back in sync, slip bits behind (or ahead of) the flywheel
+    Reg = bertJumpWord( flyReg, bertJumpPoly( (foundSlip >= 0) ? period - (uint64_t) foundSlip : (uint64_t) -foundSlip,
+                                              order, tap ), order, tap );
+    polarityMask = flyPolarity;
+    resyncSlip = foundSlip;
+    flyResyncs++;
+    syncAcquired( 1.0 );
+    return 1;
+}
+
+// sync acquisition for BERT_PN_AUTO.  Reg holds the received bits as they
+// came, every pattern in both polarities predicts the next byte from them
+// and keeps its own count of matches in a row.  The first to reach
+// lockBytes becomes the selected pattern and checking carries on from
+// there exactly as if it had been set with setPN().  Acquisition costs 16
+// predictions a byte, the locked paths nothing.
+void RxBert::acquireAuto( uint64_t FeedIn ) {
+    const BertPatternDesc *p, *found = NULL;
+    uint64_t mask, Expected;
+    unsigned int n, pol, foundPol = 0;
+
+    for ( n = 0; n < BERT_PN_MAX; n++ ) {
+        p = &bertPatternList[n];
+        for ( pol = 0; pol < 2; pol++ ) {
+            // the raw pattern register if the data is p with this polarity
+            mask = p->invert ^ (pol ? 0xFFFFFFFFFFFFFFFFULL : 0);
+            Expected = bertOutputWord( bertNextWord( Reg ^ mask, p->order, p->tap ), p );
+            Expected = (Expected ^ (pol ? 0xFFFFFFFFFFFFFFFFULL : 0)) & 0xFF;
+            if ( Expected == FeedIn ) {
+                autoWeight[n][pol]++;
+                if ( (found == NULL) && (autoWeight[n][pol] >= lockBytes) ) {
+                    found = p;
+                    foundPol = pol;
                 }
             } else {
-                windowBytes++;
-            }
-            
-            // perform sycned feedback to shift register input
-            switch (PN) {
-                case BERT_PN11:
-                    // shift up register length, add to top of shif tregister
-                    FeedBack = FeedBack << 11;
-                    Reg = Reg + FeedBack;
-                    break;
-                case BERT_PN15:
-                    // shift up register length, add to top of shif tregister
-                    FeedBack = FeedBack << 15;
-                    Reg = Reg + FeedBack;
-                    break;
-                case BERT_PN23:
-                    // shift up register length, add to top of shif tregister
-                    FeedBack = FeedBack << 23;
-                    Reg = Reg + FeedBack;
+                autoWeight[n][pol] = 0;
+            }
+        }
+    }
+    Reg = (Reg >> 8) | (FeedIn << 56);
+
+    if ( found != NULL ) {
+        // declare lock on the pattern found, the register goes raw
+        selectPattern( found->PN );
+        polarityMask = foundPol ? 0xFFFFFFFFFFFFFFFFULL : 0;
+        Reg = Reg ^ found->invert ^ polarityMask;
+        memset( autoWeight, 0, sizeof(autoWeight) );
+        syncAcquired( 1.0 );
+    }
+}
+
+// 64 received stream bits from bit b of the acquisition history
+static inline uint64_t historyWord( const uint64_t *h, unsigned int b ) {
+    unsigned int w = b / 64, s = b % 64;
+    if ( s == 0 ) {
+        return h[w];
+    }
+    return (h[w] >> s) | (h[w + 1] << (64 - s));
+}
+
+// correlation acquisition for high error rates.  One wrong bit in the
+// register throws every prediction off, but at 10% BER a register's worth
+// of bits is still clean often enough (about 1 in 26 for PN31), so instead
+// of wanting every byte to match, each register the data offers is tried:
+// at every bit position the 64 bits before it, in both polarities, predict
+// the next correlateBits and the candidate is taken when no more than a
+// fifth of them disagree.  A wrong register disagrees on about half and
+// is mostly thrown out after the first word.  A register one or two bits
+// out predicts nearly right for a while, the error only spreads through
+// the pattern over the following few hundred bits, so the check has to
+// be long enough to see it (24% wrong over 1024 bits for PN31, worse for
+// the shorter patterns).  The received bits are kept in
+// acqHistory until a candidate has correlateBits after it to be checked
+// against, and the lock lands that many bits late, with the register
+// jumped up to the current position.
+void RxBert::acquireCorrelate( uint64_t FeedIn ) {
+    unsigned int c, k, pol, mismatch, threshold = correlateBits / 5;
+    uint64_t mask, raw, w;
+
+    // keep enough history for the oldest candidate still to be tried, and a spare word for historyWord() to read past the end
+    if ( acqBits + 8 > 64 * (acqHistoryWords - 1) ) {
+        k = (acqBits - correlateBits - 64) / 64;
+        memmove( acqHistory, acqHistory + k, sizeof(uint64_t) * (acqHistoryWords - k) );
+        acqBits -= 64 * k;
+    }
+    if ( acqBits % 64 == 0 ) {
+        acqHistory[acqBits / 64] = 0;
+    }
+    acqHistory[acqBits / 64] |= FeedIn << (acqBits % 64);
+    acqBits += 8;
+    // the register for the next byte, as received
+    Reg = (Reg >> 8) | (FeedIn << 56);
+
+    if ( acqBits < 64 + correlateBits + 8 ) {
+        return;
+    }
+    for ( c = acqBits - correlateBits - 7; c <= acqBits - correlateBits; c++ ) {
+        for ( pol = 0; pol < 2; pol++ ) {
+            mask = pattern->invert ^ (pol ? 0xFFFFFFFFFFFFFFFFULL : 0);
+            raw = historyWord( acqHistory, c - 64 ) ^ mask;
+            if ( (raw >> (64 - order)) == 0 ) {
+                // the all zero register predicts all zeros, never a lock
+                continue;
+            }
+            mismatch = 0;
+            w = raw;
+            for ( k = 0; k < correlateBits; k += 64 ) {
+                w = bertNextWord( w, order, tap );
+                mismatch += __builtin_popcountll( bertOutputWord( w, pattern ) ^ (mask ^ pattern->invert) ^
+                                                  historyWord( acqHistory, c + k ) );
+                // give up as soon as the count is well past a fifth, most
+                // wrong registers go on the first word
+                if ( mismatch > (k + 64) / 5 + 16 ) {
                     break;
+                }
+            }
+            if ( (k >= correlateBits) && (mismatch <= threshold) ) {
+                // declare lock.  Only the newest order bits of raw were
+                // tried, so the register goes on from the last predicted
+                // word, which is all pattern, to the received bits
+                polarityMask = mask ^ pattern->invert;
+                Reg = bertJumpWord( w, bertJumpPoly( acqBits - c - correlateBits, order, tap ), order, tap );
+                acqBits = 0;
+                syncAcquired( 1.0 - 2.0 * mismatch / correlateBits );
+                return;
             }
         }
+    }
+}
 
-        // shift shift register 8 bit for next go-adound
-        Reg = Reg >> 8;
+// find the table position of the expected data after sync is declared
+void RxBert::locateRef() {
+    int64_t bit;
+    refValid = 0;
+    if ( table == NULL ) {
+        return;
+    }
+    bit = bertPatternLocate( pattern, predict() );
+    if ( bit >= 0 ) {
+        refIndex = bertPatternByte( (uint64_t) bit, order );
+        refValid = 1;
     }
 }
 
+// keep the table position in step with the register
+void RxBert::advanceRef( unsigned int bytes ) {
+    if ( refValid ) {
+        refIndex = (refIndex + bytes) % tableBytes;
+    }
+}
+
+// the bits on the wire for the stream word w, all ones for an unknown pattern.
+// Complemented when the link delivers the pattern inverted.
+uint64_t RxBert::expect( uint64_t w ) {
+    if ( pattern == NULL ) {
+        return w;
+    }
+    return bertOutputWord( w, pattern ) ^ polarityMask;
+}
+
+// the bits expected next if the data so far had the other polarity.  The
+// register is then the complement of what was shifted in, which does not
+// cancel out of the feedback when it reaches into the predicted bits.
+uint64_t RxBert::expectFlipped() {
+    return bertOutputWord( bertNextWord( ~Reg, order, tap ), pattern ) ^ ~polarityMask;
+}
+
+// expected next 64 bits of the pattern given the register
+uint64_t RxBert::predict() {
+    if ( order == 0 ) {
+        // unknown pattern, expect all ones
+        return 0xFFFFFFFFFFFFFFFFULL;
+    }
+    return bertNextWord( Reg, order, tap );
+}
+
+// move the reference so the next byte checked is expected to start at bit
+// bitOffset of the pattern, counted from resetState().  Sync state is kept,
+// while acquiring the register is simply reloaded from the new position.
+void RxBert::seek( uint64_t bitOffset ) {
+    uint64_t period = (1ULL << order) - 1;
+    if ( order == 0 ) {
+        return;
+    }
+    // Reg holds the 64 bits before the next expected one
+    Reg = bertJumpWord( bertSeedWord( 0xFFFFFFFF, order, tap ),
+                        bertJumpPoly( bitOffset % period + period - 64, order, tap ), order, tap );
+    if ( refValid ) {
+        refIndex = bertPatternByte( bitOffset, order );
+    }
+}
+
+// bit position within the pattern period of the next byte to be checked,
+// counted from the all ones register the way seek() and TxBert count it,
+// or -1 when not synced.  TxBert started from resetState() is at
+// getBitsTX() modulo the period, so the difference of the two is the
+// loopback delay in bits (modulo the period), and two readings a known
+// number of received bits apart show exactly how many went missing.
+int64_t RxBert::getPatternPosition() {
+    if ( !isSynced || (order == 0) ) {
+        return -1;
+    }
+    return bertPatternLocate( pattern, predict() );
+}
+
+// skip the reference ahead by bits, for data known to be missing.  The
+// jump is O(log bits), sync and the syncloss window carry on across the
+// gap and the bits are counted as dropped, not as errors.  An acquisition
+// in progress starts over, the bytes either side of the gap do not follow
+// on from each other.
+void RxBert::advance( uint64_t bits ) {
+    uint64_t period = (1ULL << order) - 1, jump;
+    droppedBits = droppedBits + bits;
+    // errors either side of the gap are at least this far apart
+    if ( burstOpen && (bitsRX - burstEnd + bits >= burstGap) ) {
+        closeBurst();
+    }
+    publishStats();
+    if ( order == 0 ) {
+        return;
+    }
+    jump = bertJumpPoly( bits, order, tap );
+    Reg = bertJumpWord( Reg, jump, order, tap );
+    if ( refValid ) {
+        refIndex = bertPatternByte( 8ULL * refIndex + bits % period, order );
+    }
+    if ( !isSynced ) {
+        syncWieght = 0;
+        acqBits = 0;
+        memset( autoWeight, 0, sizeof(autoWeight) );
+        if ( flyActive ) {
+            flyReg = bertJumpWord( flyReg, jump, order, tap );
+            memset( flyWeight, 0, sizeof(flyWeight) );
+        }
+    }
+}
+
+// check a buffer that follows missingBitsBefore bits of dropped data
+void RxBert::checkWithGap( unsigned char *buffer, unsigned int bytes, uint64_t missingBitsBefore ) {
+    if ( missingBitsBefore != 0 ) {
+        advance( missingBitsBefore );
+    }
+    check( buffer, bytes );
+}
+
 // controls
 void RxBert::resetState() {
     bitsRX = 0;
     bitErrors = 0;
     syncLossCount = 0;
     isSynced = 0;
-    windowBytes = 0;
-    windowErrors = 0;
+    clearWindow();
     bitsRXinSync = 0;
     syncWieght = 0;
 
     // reset registers to all ones (epoch)
-    Reg = 0xFFFFFFFF;
+    Reg = 0xFFFFFFFFFFFFFFFFULL;
+    refValid = 0;
+    refIndex = 0;
+    parallelResume = 0;
+    polarityMask = 0;
+    memset( autoWeight, 0, sizeof(autoWeight) );
+    acqBits = 0;
+    syncConfidence = 0;
+    outage = 0;
+    outageBits = 0;
+    droppedBits = 0;
+    flyActive = 0;
+    flyResyncs = 0;
+    resyncSlip = 0;
+    lossPending = 0;
+    insertions = 0;
+    deletions = 0;
+    insertedBits = 0;
+    deletedBits = 0;
+    lastSlipPosition = 0;
+    eventHead = 0;
+    eventTail = 0;
+    eventsLost = 0;
+    burstOpen = 0;
+    burstCount = 0;
+    memset( burstHistogram, 0, sizeof(burstHistogram) );
+    berAlarm = 0;
+    berStartBits = 0;
+    berStartErrors = 0;
+    resetMetrics();
+    verdict = BERT_VERDICT_RUNNING;
+    verdictBits = 0;
+    publishStats();
 }
 
+// BERT_PN_AUTO detects the pattern on each sync, getPN() then gives the
+// one found
 void RxBert::setPN( int PN ) {
+   autoDetect = (PN == BERT_PN_AUTO);
+   selectPattern( PN );
+}
+
+void RxBert::selectPattern( int PN ) {
    this->PN = PN;
+   pattern = bertDescriptor( PN );
+   if ( pattern != NULL ) {
+       order = pattern->order;
+       tap = pattern->tap;
+       blockJump = bertJumpPoly( 64ULL * checkBlockWords, order, tap );
+   } else {
+       order = 0;
+       tap = 0;
+   }
+   // shared full period table, NULL for patterns too long to cache
+   table = bertPatternTable( pattern, bitOrder, &tableBytes );
+   refValid = 0;
 }
 
 int RxBert::getPN() {
@@ -182,4 +1295,578 @@ unsigned long RxBert::getSyncLossCount() {
     return syncLossCount;
 }
 
+// seqlock writer, only the checking thread calls it.  statsSeq goes odd
+// before the copy is touched and even again after it, the fences keep the
+// stores in that order.
+void RxBert::publishStats() {
+    __atomic_store_n( &statsSeq, statsSeq + 1, __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+    stats.bitsRX = bitsRX;
+    stats.bitsRXinSync = bitsRXinSync;
+    stats.errors = bitErrors;
+    stats.syncLossCount = syncLossCount;
+    stats.droppedBits = droppedBits;
+    stats.outageBits = outageBits;
+    stats.synced = isSynced;
+    stats.inverted = (polarityMask != 0);
+    stats.PN = PN;
+    __atomic_store_n( &statsSeq, statsSeq + 1, __ATOMIC_RELEASE );
+
+    if ( statsPage != NULL ) {
+        bertShmBegin( statsPage );
+        statsPage->PN = PN;
+        statsPage->synced = isSynced;
+        statsPage->inverted = (polarityMask != 0);
+        statsPage->bitOrder = bitOrder;
+        statsPage->bits = bitsRX;
+        statsPage->bitsInSync = bitsRXinSync;
+        statsPage->errors = bitErrors;
+        statsPage->syncLossCount = syncLossCount;
+        statsPage->droppedBits = droppedBits;
+        statsPage->outageBits = outageBits;
+        bertShmSample( statsPage );
+        bertShmEnd( statsPage );
+    }
+}
+
+// seqlock reader, the copy is taken again if a publish overlapped it
+void RxBert::snapshot( BertStats *stats ) {
+    uint64_t seq;
+    for ( ;; ) {
+        seq = __atomic_load_n( &statsSeq, __ATOMIC_ACQUIRE );
+        if ( seq & 1 ) {
+            continue;
+        }
+        *stats = this->stats;
+        __atomic_thread_fence( __ATOMIC_ACQUIRE );
+        if ( __atomic_load_n( &statsSeq, __ATOMIC_RELAXED ) == seq ) {
+            return;
+        }
+    }
+}
+
+// 1 when the data was found to be the complement of the pattern (a 180
+// degree phase ambiguity on a BPSK link) and is being checked inverted
+unsigned int RxBert::getInverted() {
+    return (polarityMask != 0) ? 1 : 0;
+}
+
+// order of the bits within each byte, BERT_MSB_FIRST (the default) expects
+// the first bit of the pattern in bit 7, BERT_LSB_FIRST in bit 0
+void RxBert::setBitOrder( unsigned int bitOrder ) {
+    this->bitOrder = (bitOrder == BERT_LSB_FIRST) ? BERT_LSB_FIRST : BERT_MSB_FIRST;
+    // same positions, the table for the other bit order
+    table = bertPatternTable( pattern, this->bitOrder, &tableBytes );
+    if ( table == NULL ) {
+        refValid = 0;
+    }
+}
+
+unsigned int RxBert::getBitOrder() {
+    return bitOrder;
+}
+
+// fast lock.  The register is always loaded straight from the received
+// bits, so once order bits are in it predicts the pattern; the standard
+// check then wants 88 matching bits before declaring sync.  With fast lock
+// only verifyBits (rounded up to whole bytes) have to match, about
+// 2 x order bits from a fade to lock with verifyBits = order.  Random data
+// passes the check with odds of about 2^-verifyBits per byte, so short
+// patterns want more than order bits.  0 goes back to the standard check.
+void RxBert::setFastLock( unsigned int verifyBits ) {
+    fastLockBits = verifyBits;
+    lockBytes = (verifyBits != 0) ? (verifyBits + 7) / 8 : 11;
+}
+
+unsigned int RxBert::getFastLock() {
+    return fastLockBits;
+}
+
+// correlation acquisition, for error rates where lockBytes bytes in a row
+// will not match.  Sync is declared once some register from the data
+// predicts verifyBits (rounded up to whole words, up to maxCorrelateBits)
+// with no more than a fifth of them wrong, random data gets there with
+// odds below 2^-(verifyBits / 4).  1024 locks reliably up to about 12%
+// BER, shorter checks can lock on a register with a bit error in it.
+// 0 (the default) for the standard check.
+void RxBert::setCorrelationLock( unsigned int verifyBits ) {
+    if ( verifyBits > maxCorrelateBits ) {
+        verifyBits = maxCorrelateBits;
+    }
+    correlateBits = 64 * ((verifyBits + 63) / 64);
+    acqBits = 0;
+}
+
+unsigned int RxBert::getCorrelationLock() {
+    return correlateBits;
+}
+
+// agreement between the data and the pattern over the bits that declared
+// the last lock, 1 - 2 x the fraction that differed.  About 1 - 2 x BER
+// for a real lock, 1 for the standard check, near 0 for random data.
+double RxBert::getSyncConfidence() {
+    return syncConfidence;
+}
+
+// flywheel reacquisition after a syncloss, slipBits is how far either way
+// the data may have slipped during the outage, up to maxFlywheelSlip
+void RxBert::setFlywheel( unsigned int enable, unsigned int slipBits ) {
+    flywheel = enable ? 1 : 0;
+    flySlip = (slipBits > maxFlywheelSlip) ? maxFlywheelSlip : slipBits;
+    flyActive = 0;
+}
+
+unsigned int RxBert::getFlywheel() {
+    return flywheel;
+}
+
+// slip detection.  A syncloss is first taken to be a bit slip of up to
+// maxSlip bits either way: the reference is carried on as with the
+// flywheel, and if the data matches it again at a slip within a couple of
+// windows sync carries on there, the slip is counted as an insertion
+// (data late) or a deletion (data early) and no syncloss is counted.
+// The errors in the window that fired stay counted.  0 (the default)
+// turns it off.
+void RxBert::setSlipDetect( unsigned int maxSlip ) {
+    slipMax = (maxSlip > maxFlywheelSlip) ? maxFlywheelSlip : maxSlip;
+}
+
+unsigned int RxBert::getSlipDetect() {
+    return slipMax;
+}
+
+unsigned long RxBert::getInsertions() {
+    return insertions;
+}
+
+unsigned long RxBert::getDeletions() {
+    return deletions;
+}
+
+unsigned long RxBert::getInsertedBits() {
+    return insertedBits;
+}
+
+unsigned long RxBert::getDeletedBits() {
+    return deletedBits;
+}
+
+// received bit position (bitsRX) of the word the errors from the last slip
+// start in, or of an errored word up to a syncloss window before it,
+// never before the sync it slipped out of
+unsigned long RxBert::getLastSlipPosition() {
+    return lastSlipPosition;
+}
+
+// events rounded up to a power of 2, 0 to turn the log off.  The ring is
+// cleared along with the burst counts.  Not to be called while check() is
+// running.
+void RxBert::setErrorLog( unsigned int events, unsigned int burstGap ) {
+    unsigned int size = 1;
+    delete [] eventRing;
+    eventRing = NULL;
+    eventSize = 0;
+    if ( events != 0 ) {
+        while ( size < events ) {
+            size <<= 1;
+        }
+        eventRing = new BertErrorEvent[size];
+        eventSize = size;
+    }
+    errorDetail = (eventRing != NULL) || (eventFn != NULL);
+    this->burstGap = burstGap;
+    eventHead = 0;
+    eventTail = 0;
+    eventsLost = 0;
+    burstOpen = 0;
+    burstCount = 0;
+    memset( burstHistogram, 0, sizeof(burstHistogram) );
+}
+
+// the callback runs on the thread calling check(), in the middle of it
+void RxBert::setEventCallback( BertEventCallback fn, void *arg ) {
+    eventFn = fn;
+    eventArg = arg;
+    errorDetail = (eventRing != NULL) || (eventFn != NULL);
+}
+
+void RxBert::getEventCallback( BertEventCallback *fn, void **arg ) {
+    *fn = eventFn;
+    *arg = eventArg;
+}
+
+void RxBert::setBerAlarm( double threshold, uint64_t windowBits ) {
+    berThreshold = threshold;
+    berWindowBits = (windowBits != 0) ? windowBits : 1;
+    berAlarm = 0;
+    berStartBits = bitsRXinSync;
+    berStartErrors = bitErrors;
+}
+
+unsigned int RxBert::getBerAlarm() {
+    return berAlarm;
+}
+
+// what the last check() call added is spread over the time since the one
+// before it and every second that closes in that time is classified
+void RxBert::updateMetrics() {
+    uint64_t now, span, done = 0, bits, lost, errors, b, l, e, b0 = 0, l0 = 0, e0 = 0;
+
+    if ( metricsBase == BERT_METRICS_OFF ) {
+        return;
+    }
+    now = (metricsBase == BERT_METRICS_WALL) ? monotonicNs() : bitsRX + droppedBits;
+    if ( !metricsStarted ) {
+        if ( !isSynced ) {
+            return;
+        }
+        metricsStarted = 1;
+        metricsTick = now;
+        metricsSecondEnd = now + metricsSecond;
+        metricsLine = bitsRX + droppedBits;
+        metricsInSync = bitsRXinSync;
+        metricsErrors = bitErrors;
+        return;
+    }
+
+    bits = bitsRX + droppedBits - metricsLine;
+    lost = bits - (bitsRXinSync - metricsInSync);
+    errors = bitErrors - metricsErrors;
+    metricsLine = bitsRX + droppedBits;
+    metricsInSync = bitsRXinSync;
+    metricsErrors = bitErrors;
+
+    span = now - metricsTick;
+    if ( span == 0 ) {
+        secBits += bits;
+        secLost += lost;
+        secErrors += errors;
+        return;
+    }
+    while ( metricsTick < now ) {
+        done += ((metricsSecondEnd < now) ? metricsSecondEnd : now) - metricsTick;
+        metricsTick = (metricsSecondEnd < now) ? metricsSecondEnd : now;
+        b = proRata( bits, done, span );
+        l = proRata( lost, done, span );
+        e = proRata( errors, done, span );
+        secBits += b - b0;
+        secLost += l - l0;
+        secErrors += e - e0;
+        b0 = b;
+        l0 = l;
+        e0 = e;
+        if ( metricsTick == metricsSecondEnd ) {
+            closeSecond();
+            metricsSecondEnd += metricsSecond;
+        }
+    }
+}
+
+// classify the second just ended.  A run of SES, or of non-SES seconds
+// while unavailable, is held back until it either reaches unavailableRun
+// or is broken, then counted as a whole.
+void RxBert::closeSecond() {
+    uint64_t inSync = secBits - secLost;
+    unsigned int ses, es;
+
+    intervalBer = (inSync != 0) ? (double) secErrors / (double) inSync : -1;
+    ses = (secLost != 0) || (secBits == 0) || (intervalBer >= sesBer);
+    es = ses || (secErrors != 0);
+    metricSeconds++;
+    secBits = 0;
+    secLost = 0;
+    secErrors = 0;
+
+    if ( !unavailable ) {
+        if ( ses ) {
+            if ( ++runSeconds == unavailableRun ) {
+                unavailable = 1;
+                unavailableSeconds += runSeconds;
+                runSeconds = 0;
+            }
+            return;
+        }
+        erroredSeconds += runSeconds;
+        severelyErroredSeconds += runSeconds;
+        runSeconds = 0;
+        if ( es ) {
+            erroredSeconds++;
+        } else {
+            errorFreeSeconds++;
+        }
+    } else {
+        if ( !ses ) {
+            runErrored += es;
+            if ( ++runSeconds == unavailableRun ) {
+                unavailable = 0;
+                erroredSeconds += runErrored;
+                errorFreeSeconds += runSeconds - runErrored;
+                runSeconds = 0;
+                runErrored = 0;
+            }
+            return;
+        }
+        unavailableSeconds += runSeconds + 1;
+        runSeconds = 0;
+        runErrored = 0;
+    }
+}
+
+// timeBase BERT_METRICS_BITS counts seconds of bitsPerSecond line bits,
+// dropped bits included, BERT_METRICS_WALL seconds of the monotonic clock.
+// G.821 puts sesBer at 1e-3.  Clears the counts.
+void RxBert::setMetrics( unsigned int timeBase, uint64_t bitsPerSecond, double sesBer ) {
+    metricsBase = (timeBase <= BERT_METRICS_WALL) ? timeBase : BERT_METRICS_OFF;
+    if ( metricsBase == BERT_METRICS_WALL ) {
+        metricsSecond = 1000000000ULL;
+    } else {
+        metricsSecond = (bitsPerSecond != 0) ? bitsPerSecond : 1;
+    }
+    this->sesBer = sesBer;
+    resetMetrics();
+}
+
+void RxBert::resetMetrics() {
+    metricsStarted = 0;
+    secBits = 0;
+    secLost = 0;
+    secErrors = 0;
+    unavailable = 0;
+    runSeconds = 0;
+    runErrored = 0;
+    metricSeconds = 0;
+    erroredSeconds = 0;
+    severelyErroredSeconds = 0;
+    errorFreeSeconds = 0;
+    unavailableSeconds = 0;
+    intervalBer = -1;
+}
+
+unsigned long RxBert::getMetricSeconds() {
+    return metricSeconds;
+}
+
+unsigned long RxBert::getErroredSeconds() {
+    return erroredSeconds;
+}
+
+unsigned long RxBert::getSeverelyErroredSeconds() {
+    return severelyErroredSeconds;
+}
+
+unsigned long RxBert::getErrorFreeSeconds() {
+    return errorFreeSeconds;
+}
+
+unsigned long RxBert::getUnavailableSeconds() {
+    return unavailableSeconds;
+}
+
+double RxBert::getIntervalBer() {
+    return intervalBer;
+}
+
+void RxBert::setConfidenceMethod( unsigned int method ) {
+    ciMethod = (method == BERT_CI_WILSON) ? BERT_CI_WILSON : BERT_CI_CLOPPER_PEARSON;
+}
+
+unsigned int RxBert::getConfidenceMethod() {
+    return ciMethod;
+}
+
+double RxBert::getBerUpper( double confidence ) {
+    double n = (double) bitsRXinSync, p, z = normalQuantile( confidence ), bound;
+    if ( bitsRXinSync == 0 ) {
+        return 1;
+    }
+    if ( ciMethod == BERT_CI_WILSON ) {
+        p = (double) bitErrors / n;
+        bound = (p + z * z / (2 * n) + z * sqrt( p * (1 - p) / n + z * z / (4 * n * n) )) / (1 + z * z / n);
+    } else {
+        bound = poissonBound( bitErrors, confidence, z, 1 ) / n;
+    }
+    return (bound < 1) ? bound : 1;
+}
+
+double RxBert::getBerLower( double confidence ) {
+    double n = (double) bitsRXinSync, p, z = normalQuantile( confidence ), bound;
+    if ( bitsRXinSync == 0 ) {
+        return 0;
+    }
+    if ( ciMethod == BERT_CI_WILSON ) {
+        p = (double) bitErrors / n;
+        bound = (p + z * z / (2 * n) - z * sqrt( p * (1 - p) / n + z * z / (4 * n * n) )) / (1 + z * z / n);
+    } else {
+        bound = poissonBound( bitErrors, confidence, z, 0 ) / n;
+    }
+    return (bound > 0) ? bound : 0;
+}
+
+// a verdict taken after every call is a sequential test, so the error
+// rate of the decision is somewhat above 1 - confidence
+void RxBert::checkVerdict() {
+    double c;
+    if ( (verdict != BERT_VERDICT_RUNNING) || (bitsRXinSync == verdictBits) ) {
+        return;
+    }
+    verdictBits = bitsRXinSync;
+    if ( targetBer > 0 ) {
+        if ( getBerUpper( targetConfidence ) < targetBer ) {
+            verdict = BERT_VERDICT_PASS;
+        } else if ( getBerLower( targetConfidence ) > targetBer ) {
+            verdict = BERT_VERDICT_FAIL;
+        }
+    }
+    if ( (verdict == BERT_VERDICT_RUNNING) && (precision > 0) && (bitErrors != 0) ) {
+        c = (1 + precisionConfidence) / 2;
+        if ( getBerUpper( c ) - getBerLower( c ) <= 2 * precision * bitErrors / (double) bitsRXinSync ) {
+            verdict = BERT_VERDICT_PRECISE;
+        }
+    }
+    if ( verdict != BERT_VERDICT_RUNNING ) {
+        fireEvent( BERT_EVENT_VERDICT, bitsRX, verdict );
+    }
+}
+
+void RxBert::setBerTarget( double maxBer, double confidence ) {
+    targetBer = maxBer;
+    targetConfidence = confidence;
+    verdict = BERT_VERDICT_RUNNING;
+    verdictBits = 0;
+}
+
+void RxBert::setBerPrecision( double relative, double confidence ) {
+    precision = relative;
+    precisionConfidence = confidence;
+    verdict = BERT_VERDICT_RUNNING;
+    verdictBits = 0;
+}
+
+unsigned int RxBert::getBerVerdict() {
+    return verdict;
+}
+
+unsigned int RxBert::getErrorLog() {
+    return eventSize;
+}
+
+// oldest unread event, 1 if there was one.  One reader; a slot the writer
+// has come round to while it was copied is skipped as lost.
+unsigned int RxBert::readErrorEvent( BertErrorEvent *event ) {
+    uint64_t head;
+
+    if ( eventRing == NULL ) {
+        return 0;
+    }
+    for ( ;; ) {
+        head = __atomic_load_n( &eventHead, __ATOMIC_ACQUIRE );
+        if ( head == eventTail ) {
+            return 0;
+        }
+        if ( head - eventTail > eventSize ) {
+            eventsLost += head - eventTail - eventSize;
+            eventTail = head - eventSize;
+        }
+        *event = eventRing[eventTail & (eventSize - 1)];
+        __atomic_thread_fence( __ATOMIC_ACQUIRE );
+        head = __atomic_load_n( &eventHead, __ATOMIC_RELAXED );
+        if ( head - eventTail < eventSize ) {
+            eventTail++;
+            return 1;
+        }
+        eventsLost++;
+        eventTail++;
+    }
+}
+
+unsigned long RxBert::getErrorEventsLost() {
+    return eventsLost;
+}
+
+// bursts ended by the last check() or advance() call.  A burst is only
+// known to have ended once burstGap error free bits have gone by, the
+// one still running is not counted yet.
+unsigned long RxBert::getBurstCount() {
+    return burstCount;
+}
+
+unsigned long RxBert::getBurstHistogram( unsigned int bin ) {
+    return (bin < burstBins) ? burstHistogram[bin] : 0;
+}
+
+// bits reported missing through advance() or checkWithGap()
+unsigned long RxBert::getDroppedBits() {
+    return droppedBits;
+}
+
+// bits received between a syncloss and the next lock, kept out of the
+// error count
+unsigned long RxBert::getOutageBits() {
+    return outageBits;
+}
+
+// syncs brought back by the flywheel, and the slip found by the last one,
+// positive when the data came in that many bits late
+unsigned long RxBert::getFlywheelResyncs() {
+    return flyResyncs;
+}
+
+int RxBert::getResyncSlip() {
+    return resyncSlip;
+}
+
+// syncloss detection.  The window covers the last windowBits received
+// and drops sync once more than maxErrors errors are in it, so errors
+// spread over a long run never add up to a syncloss but a burst does
+// wherever it falls.  It slides a whole word at a time, the words with
+// errors in them are kept in a ring and their sum is the count, so a
+// word costs the same whatever the window.  The window in progress is
+// started over.
+void RxBert::setSyncLoss( unsigned int windowBits, unsigned int maxErrors ) {
+    if ( windowBits < 64 ) {
+        windowBits = 64;
+    }
+    lossWindowBytes = 8 * ((windowBits + 63) / 64);
+    lossErrors = maxErrors;
+    for ( lossRingSize = 1; lossRingSize < lossWindowBytes / 8; lossRingSize *= 2 ) {
+    }
+    delete [] lossRing;
+    lossRing = new BertLossWord[lossRingSize];
+    clearWindow();
+}
+
+unsigned int RxBert::getSyncLossWindow() {
+    return 8 * lossWindowBytes;
+}
+
+unsigned int RxBert::getSyncLossErrors() {
+    return lossErrors;
+}
+
+// threads used for large buffers, 0 for one per CPU, 1 to stay serial
+void RxBert::setThreads( unsigned int threads ) {
+    this->threads = threads;
+}
+
+unsigned int RxBert::getThreads() {
+    return threads;
+}
+
+int RxBert::setStatsPage( const char *name, uint64_t sampleBits ) {
+    bertShmDestroy( statsPage, statsName );
+    free( statsName );
+    statsPage = NULL;
+    statsName = NULL;
+    if ( (name == NULL) || (name[0] == 0) ) {
+        return 0;
+    }
+    statsPage = bertShmCreate( name, BERT_SHM_RX, sampleBits );
+    if ( statsPage == NULL ) {
+        return -1;
+    }
+    statsName = strdup( name );
+    publishStats();
+    return 0;
+}
+
 
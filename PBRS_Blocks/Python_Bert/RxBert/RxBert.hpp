@@ -5,9 +5,14 @@
    Peter R Fetterer <Peter.R.Fetterer@nasa.gov>
 
    Sequences we are generating:
-       PN11 --  2^11-1 test pattern
-       PN15 --  2^15-1 test pattern
+       PN7    -- 2^7-1  test pattern
+       PN9    -- 2^9-1  test pattern
+       PN11   -- 2^11-1 test pattern
+       PN15   -- 2^15-1 test pattern
+       PN20   -- 2^20-1 Test Sequence
+       PN20SZ -- 2^20-1 Zero Suppressed Pattern
        PN23   -- 2^23-1 test pattern
+       PN31   -- 2^31-1 test pattern
 
 */
 
@@ -16,8 +21,82 @@
 
 #include "BertCommon.hpp"
 
-// syncloss detection window length (bytes)
-#define windowLength 10  
+// syncloss detection defaults, a window with more than syncLossErrors bit
+// errors in it declares syncloss
+#define syncLossWindowBits 128
+#define syncLossErrors 28
+
+// longest correlation acquisition check (bits)
+#define maxCorrelateBits 4096
+
+// a word with errors in it still inside the syncloss window
+struct BertLossWord {
+    uint64_t word;          // words since sync was gained
+    unsigned int errors;
+};
+
+// widest slip the flywheel looks for either way (bits)
+#define maxFlywheelSlip 32
+
+// time bases for setMetrics()
+#define BERT_METRICS_OFF  0
+#define BERT_METRICS_BITS 1     // a second is bitsPerSecond line bits
+#define BERT_METRICS_WALL 2     // a second of CLOCK_MONOTONIC
+
+// consecutive SES that start unavailable time, and non-SES seconds that
+// end it (G.821, G.826)
+#define unavailableRun 10
+
+// burst length histogram bins, bin b counts bursts of 2^b to 2^(b+1)-1 bits
+#define burstBins 32
+
+// one received word with bit errors in it, from the error log
+struct BertErrorEvent {
+    uint64_t bitOffset;     // received bit (bitsRX) of bit 0 of mask
+    uint64_t mask;          // bits in error, bit j is bitOffset + j
+    uint64_t run;           // length so far of the burst the last error is in (bits)
+};
+
+// the counters as of the end of one check() call, see snapshot()
+struct BertStats {
+    uint64_t bitsRX;
+    uint64_t bitsRXinSync;
+    uint64_t errors;
+    uint64_t syncLossCount;
+    uint64_t droppedBits;
+    uint64_t outageBits;
+    uint32_t synced;
+    uint32_t inverted;
+    int32_t PN;
+};
+
+// events passed to the setEventCallback() function
+#define BERT_EVENT_SYNC        1    // value is the lock confidence
+#define BERT_EVENT_SYNCLOSS    2
+#define BERT_EVENT_BURST_START 3
+#define BERT_EVENT_BURST_END   4    // value is the burst length in bits
+#define BERT_EVENT_BER_ALARM   5    // value is the BER of the window
+#define BERT_EVENT_BER_CLEAR   6
+#define BERT_EVENT_VERDICT     7    // value is the BERT_VERDICT_*
+
+// confidence interval methods for setConfidenceMethod()
+#define BERT_CI_CLOPPER_PEARSON 0
+#define BERT_CI_WILSON          1
+
+// getBerVerdict()
+#define BERT_VERDICT_RUNNING 0
+#define BERT_VERDICT_PASS    1      // BER below the target at the confidence
+#define BERT_VERDICT_FAIL    2      // BER above the target at the confidence
+#define BERT_VERDICT_PRECISE 3      // BER known to the precision asked for
+
+struct BertEvent {
+    uint32_t type;          // BERT_EVENT_*
+    uint64_t time;          // CLOCK_MONOTONIC when it was seen, ns
+    uint64_t bitPosition;   // received bit (bitsRX) it happened at
+    double value;
+};
+
+typedef void (*BertEventCallback)( void *arg, const BertEvent *event );
 
 class RxBert {
     public:
@@ -26,9 +105,20 @@ class RxBert {
 
         // tell this object to generate the next n bytes of the sequence
         void check( unsigned char *buffer, unsigned int bytes );
+        void checkWithGap( unsigned char *buffer, unsigned int bytes, uint64_t missingBitsBefore );
+
+        // jump the reference to bit bitOffset of the pattern, or skip bits
+        // ahead of where it is now, without checking the data in between
+        void seek( uint64_t bitOffset );
+        void advance( uint64_t bits );
+        unsigned long getDroppedBits();
+
+        // bit position in the pattern period of the next byte, -1 if not synced
+        int64_t getPatternPosition();
 
         // controls
         void resetState();
+        // BERT_PN_AUTO to lock on whichever pattern is being sent
         void setPN( int PN );
         int getPN();
         unsigned long getBitsRX();
@@ -36,18 +126,273 @@ class RxBert {
         unsigned long getErrors();
         unsigned int synced();
         unsigned long getSyncLossCount();
+        unsigned int getInverted();
+
+        // all of the above from one instant, safe to call from another
+        // thread while check() runs, check() never waits on it
+        void snapshot( BertStats *stats );
+
+        // declare sync after verifyBits matching bits instead of 88,
+        // 0 (the default) for the standard check
+        void setFastLock( unsigned int verifyBits );
+        unsigned int getFastLock();
+
+        // lock at high error rates, when verifyBits predicted from the
+        // data agree with it to 80% or better, 1024 is a good choice, 0
+        // (the default) for the standard check.  getSyncConfidence() rates the last lock.
+        void setCorrelationLock( unsigned int verifyBits );
+        unsigned int getCorrelationLock();
+        double getSyncConfidence();
+
+        // keep the reference running through a syncloss and look for the
+        // data again there, up to slipBits either way, before the cold
+        // search finds it.  Off by default.
+        void setFlywheel( unsigned int enable, unsigned int slipBits );
+        unsigned int getFlywheel();
+        unsigned long getOutageBits();
+        unsigned long getFlywheelResyncs();
+        int getResyncSlip();
+
+        // tell bit slips of up to maxSlip bits apart from syncloss, 0 (the
+        // default) for off
+        void setSlipDetect( unsigned int maxSlip );
+        unsigned int getSlipDetect();
+        unsigned long getInsertions();
+        unsigned long getDeletions();
+        unsigned long getInsertedBits();
+        unsigned long getDeletedBits();
+        unsigned long getLastSlipPosition();
+
+        // log the words with errors in them to a ring of events (rounded up
+        // to a power of 2, the oldest are overwritten) and histogram the
+        // burst lengths, errors less than burstGap bits apart are one
+        // burst.  0 events (the default) for off.  readErrorEvent() is safe
+        // from another thread while check() runs, returns 0 once empty.
+        // The burst counts cover the bursts ended by the last check() or
+        // advance() call, reading them changes nothing.
+        void setErrorLog( unsigned int events, unsigned int burstGap );
+        unsigned int getErrorLog();
+        unsigned int readErrorEvent( BertErrorEvent *event );
+        unsigned long getErrorEventsLost();
+        unsigned long getBurstCount();
+        unsigned long getBurstHistogram( unsigned int bin );
+
+        // call fn( arg, event ) from check() for each BertEvent, NULL to
+        // stop.  Burst events use the burstGap from setErrorLog(), with the
+        // log itself on or off.  The end of a burst is seen burstGap bits
+        // later, by the end of the check() call at the latest.
+        void setEventCallback( BertEventCallback fn, void *arg );
+        void getEventCallback( BertEventCallback *fn, void **arg );
+
+        // BER_ALARM when the BER over windowBits synced bits (checked at the
+        // end of each check() call) goes above threshold, BER_CLEAR when a
+        // window is back at or below it.  0 threshold (the default) for off.
+        void setBerAlarm( double threshold, uint64_t windowBits );
+        unsigned int getBerAlarm();
+
+        // G.821/G.826 performance counts, kept from the end of the first
+        // check() call in sync.  A second is SES with syncloss in it (or,
+        // on the wall clock, no data at all) or a BER of sesBer or worse,
+        // ES with any error.  unavailableRun SES in a row start
+        // unavailable time and as many non-SES seconds end it, both
+        // counted from the first of the run, so the counts lag by up to
+        // that many seconds.  ES, SES and EFS are available time only.
+        // Buffers are the resolution, a buffer spanning seconds is shared
+        // between them pro rata.
+        void setMetrics( unsigned int timeBase, uint64_t bitsPerSecond, double sesBer );
+        unsigned long getMetricSeconds();
+        unsigned long getErroredSeconds();
+        unsigned long getSeverelyErroredSeconds();
+        unsigned long getErrorFreeSeconds();
+        unsigned long getUnavailableSeconds();
+        // BER of the last second, -1 if it had no bits in sync
+        double getIntervalBer();
+
+        // one sided bounds on the BER so far (errors over bits in sync),
+        // the true BER is below getBerUpper( c ) with confidence c.
+        // Clopper-Pearson (the default) is exact and conservative, Wilson
+        // narrower but optimistic with few errors.
+        void setConfidenceMethod( unsigned int method );
+        unsigned int getConfidenceMethod();
+        double getBerUpper( double confidence );
+        double getBerLower( double confidence );
+
+        // early stop.  The verdict is PASS once the BER is below maxBer
+        // with the confidence, FAIL once it is above, or PRECISE once the
+        // two sided interval at the confidence is within relative of the
+        // estimate, and stays there until resetState().  Checked after
+        // every check() call, which fires BERT_EVENT_VERDICT when it is
+        // reached.  0 for off (the default).
+        void setBerTarget( double maxBer, double confidence );
+        void setBerPrecision( double relative, double confidence );
+        unsigned int getBerVerdict();
+
+        // declare syncloss when the last windowBits (rounded up to whole
+        // 64 bit words) have more than maxErrors bit errors in them, the
+        // window slides a word at a time
+        void setSyncLoss( unsigned int windowBits, unsigned int maxErrors );
+        unsigned int getSyncLossWindow();
+        unsigned int getSyncLossErrors();
+
+        // BERT_MSB_FIRST (default) or BERT_LSB_FIRST within each byte
+        void setBitOrder( unsigned int bitOrder );
+        unsigned int getBitOrder();
+
+        // synced buffers of 2 MB and up are checked on this many threads,
+        // 0 (the default) for one per CPU
+        void setThreads( unsigned int threads );
+        unsigned int getThreads();
+
+        // publish the snapshot() counters to the shared memory segment name
+        // as well, with a sample for the history every sampleBits.  NULL or
+        // "" stops.  0 on success, -1 if it could not be created.
+        int setStatsPage( const char *name, uint64_t sampleBits );
 
     private:
+        unsigned int checkParallel( unsigned char *buffer, unsigned int bytes );
+        void checkByte( unsigned char byteIn );
+        void acquireAuto( uint64_t FeedIn );
+        void acquireCorrelate( uint64_t FeedIn );
+        unsigned int flywheelByte( uint64_t FeedIn );
+        void syncAcquired( double confidence );
+        void syncLost();
+        unsigned int slipHuntBytes();
+        void selectPattern( int PN );
+        unsigned int checkSynced( unsigned char *buffer, unsigned int bytes );
+        unsigned int checkWord( unsigned char *buffer );
+        unsigned int slideWords( unsigned char *buffer, unsigned int bytes );
+        void tableReg( unsigned int bytes );
+        unsigned int slideWindow( unsigned int errors );
+        void slideClean( uint64_t words );
+        void slideBlock( const unsigned char *buffer, unsigned int bytes, uint64_t errors, uint64_t reg );
+        void clearWindow();
+        uint64_t predict();
+        uint64_t expect( uint64_t w );
+        uint64_t expectFlipped();
+        void locateRef();
+        void advanceRef( unsigned int bytes );
+        void logBlock( const unsigned char *buffer, unsigned int bytes, uint64_t reg, uint64_t position );
+        void logErrors( uint64_t position, uint64_t diff );
+        void closeBurst();
+        void fireEvent( unsigned int type, uint64_t position, double value );
+        void checkBerAlarm();
+        void updateMetrics();
+        void closeSecond();
+        void resetMetrics();
+        void checkVerdict();
+        void publishStats();
+
         unsigned int PN;
-        unsigned int Reg;
+        unsigned int autoDetect;    // set with BERT_PN_AUTO
+        unsigned int autoWeight[BERT_PN_MAX][2];   // matches in a row, per polarity
+        const BertPatternDesc *pattern;  // NULL for an unknown PN
+        unsigned int order;     // register length of the selected pattern
+        unsigned int tap;       // feedback tap of the selected pattern
+        uint64_t Reg;           // last 64 bits of the pattern, newest in bit 63
+        uint64_t blockJump;     // jump operator for one bulk check block
+        const unsigned char *table;  // full period table, NULL if not cached
+        unsigned int tableBytes;
+        unsigned int refIndex;  // table byte of the next expected byte
+        unsigned int refValid;  // refIndex is in step with Reg
         unsigned long bitsRX;
         unsigned long bitsRXinSync;
         unsigned long bitErrors;
         unsigned long syncLossCount;
         unsigned int isSynced;
+        uint64_t polarityMask;  // all ones while the data is inverted
         int syncWieght;
-        unsigned int windowBytes;
-        unsigned int windowErrors;
+        unsigned int lockBytes;     // matching bytes needed to declare sync
+        unsigned int fastLockBits;
+        unsigned int correlateBits; // correlation acquisition, 0 if off
+        static const unsigned int acqHistoryWords = 2 * (maxCorrelateBits / 64 + 2);
+        uint64_t acqHistory[acqHistoryWords];  // received stream bits, oldest first
+        unsigned int acqBits;       // bits in acqHistory
+        double syncConfidence;
+        unsigned int outage;        // lost sync and not found it again yet
+        unsigned long outageBits;
+        unsigned long droppedBits;
+        unsigned int flywheel;      // flywheel reacquisition on
+        unsigned int flySlip;
+        unsigned int flyActive;     // flywheel running through an outage
+        uint64_t flyReg;            // reference carried through the outage
+        uint64_t flyPolarity;
+        unsigned int flyWeight[2 * maxFlywheelSlip + 1];  // matches in a row, per slip
+        unsigned int flyRange;      // slip searched in this outage
+        unsigned int flyBytes;      // bytes into the outage
+        unsigned long flyResyncs;
+        int resyncSlip;
+        unsigned int slipMax;       // slip detection, 0 if off
+        unsigned int lossPending;   // syncloss waiting on the slip detector
+        unsigned long lossStart;    // first word with errors in the window at the last syncloss
+        unsigned long insertions;
+        unsigned long deletions;
+        unsigned long insertedBits;
+        unsigned long deletedBits;
+        unsigned long lastSlipPosition;
+        unsigned int wordBytes;     // bytes into the word the window is waiting on
+        unsigned int wordErrors;    // errors so far in that word
+        unsigned int windowErrors;  // errors in the last lossWindowBytes whole words
+        uint64_t lossWords;         // whole words since sync was gained
+        BertLossWord *lossRing;     // errored words in the window, oldest first
+        unsigned int lossRingSize;  // power of 2, at least the window in words
+        unsigned int lossHead;
+        unsigned int lossUsed;
+        unsigned int lossWindowBytes;
+        unsigned int lossErrors;
+        unsigned int threads;
+        unsigned int bitOrder;  // BERT_MSB_FIRST or BERT_LSB_FIRST
+        unsigned long parallelResume;   // bitsRX before trying the pool again
+        unsigned int errorDetail;   // logErrors() wanted, log or callback
+        BertErrorEvent *eventRing;  // error log, NULL if off
+        unsigned int eventSize;     // power of 2
+        uint64_t eventHead;         // events written, only check() moves it
+        uint64_t eventTail;         // events read
+        unsigned long eventsLost;   // overwritten before they were read
+        unsigned int burstGap;
+        unsigned int burstOpen;     // a burst is running
+        uint64_t burstStart;        // first and last error bit of it
+        uint64_t burstEnd;
+        unsigned long burstCount;
+        unsigned long burstHistogram[burstBins];
+        BertStats stats;            // published copy for snapshot()
+        uint64_t statsSeq;          // odd while stats is being written
+        BertEventCallback eventFn;  // NULL if off
+        void *eventArg;
+        double berThreshold;        // BER alarm, 0 if off
+        uint64_t berWindowBits;
+        unsigned int berAlarm;      // raised
+        unsigned long berStartBits; // bitsRXinSync and errors at the window start
+        unsigned long berStartErrors;
+        unsigned int metricsBase;       // BERT_METRICS_*
+        uint64_t metricsSecond;         // ticks per second, bits or ns
+        double sesBer;
+        unsigned int metricsStarted;
+        uint64_t metricsTick;           // time of the last update
+        uint64_t metricsSecondEnd;
+        uint64_t metricsLine;           // bitsRX + droppedBits at the last update
+        uint64_t metricsInSync;         // bitsRXinSync and errors at the last update
+        uint64_t metricsErrors;
+        uint64_t secBits;               // the second in progress
+        uint64_t secLost;               // bits of it out of sync
+        uint64_t secErrors;
+        unsigned int unavailable;
+        unsigned int runSeconds;        // SES in a row, or non-SES while unavailable
+        unsigned int runErrored;        // ES among the non-SES run
+        unsigned long metricSeconds;
+        unsigned long erroredSeconds;
+        unsigned long severelyErroredSeconds;
+        unsigned long errorFreeSeconds;
+        unsigned long unavailableSeconds;
+        double intervalBer;
+        unsigned int ciMethod;          // BERT_CI_*
+        double targetBer;               // early stop, 0 if off
+        double targetConfidence;
+        double precision;               // relative, 0 if off
+        double precisionConfidence;
+        unsigned int verdict;           // BERT_VERDICT_*
+        unsigned long verdictBits;      // bitsRXinSync at the last check
+        BertShmPage *statsPage;     // NULL unless setStatsPage()
+        char *statsName;
         
         
 };
@@ -1,24 +1,232 @@
 %module RxBert
 %include typemaps.i
+%include stdint.i
 %{
 #include "RxBert.hpp"
+
+// setEventCallback() from Python, arg is the callable.  It takes the GIL
+// itself so check() can be running on any thread.
+static void RxBertPythonEvent( void *arg, const BertEvent *event ) {
+    PyGILState_STATE gil = PyGILState_Ensure();
+    PyObject *r = PyObject_CallFunction( (PyObject *) arg, (char *) "IKKd", event->type,
+                                         (unsigned long long) event->time,
+                                         (unsigned long long) event->bitPosition, event->value );
+    if ( r == NULL ) {
+        PyErr_Print();
+    } else {
+        Py_DECREF( r );
+    }
+    PyGILState_Release( gil );
+}
+
+// drop the reference to a callable set from Python
+static void RxBertPythonRelease( RxBert *rx ) {
+    BertEventCallback fn;
+    void *arg;
+    rx->getEventCallback( &fn, &arg );
+    if ( fn == RxBertPythonEvent ) {
+        rx->setEventCallback( NULL, NULL );
+        Py_DECREF( (PyObject *) arg );
+    }
+}
 %}
 
+// pattern numbers for setPN()
+#define BERT_PN7    1
+#define BERT_PN9    2
+#define BERT_PN11   3
+#define BERT_PN15   4
+#define BERT_PN20   5
+#define BERT_PN20SZ 6
+#define BERT_PN23   7
+#define BERT_PN31   8
+#define BERT_PN_AUTO 0
+
+// time bases for setMetrics()
+#define BERT_METRICS_OFF  0
+#define BERT_METRICS_BITS 1
+#define BERT_METRICS_WALL 2
+
+// events passed to the setEventCallback() callable
+#define BERT_EVENT_SYNC        1
+#define BERT_EVENT_SYNCLOSS    2
+#define BERT_EVENT_BURST_START 3
+#define BERT_EVENT_BURST_END   4
+#define BERT_EVENT_BER_ALARM   5
+#define BERT_EVENT_BER_CLEAR   6
+#define BERT_EVENT_VERDICT     7
+
+// setConfidenceMethod()
+#define BERT_CI_CLOPPER_PEARSON 0
+#define BERT_CI_WILSON          1
+
+// getBerVerdict()
+#define BERT_VERDICT_RUNNING 0
+#define BERT_VERDICT_PASS    1
+#define BERT_VERDICT_FAIL    2
+#define BERT_VERDICT_PRECISE 3
+
+// bit orders for setBitOrder()
+#define BERT_MSB_FIRST 0
+#define BERT_LSB_FIRST 1
+
+// one received word with bit errors in it, from readErrorEvent()
+struct BertErrorEvent {
+    uint64_t bitOffset;
+    uint64_t mask;
+    uint64_t run;
+};
+
+// the counters from one instant, from snapshot()
+struct BertStats {
+    uint64_t bitsRX;
+    uint64_t bitsRXinSync;
+    uint64_t errors;
+    uint64_t syncLossCount;
+    uint64_t droppedBits;
+    uint64_t outageBits;
+    uint32_t synced;
+    uint32_t inverted;
+    int32_t PN;
+};
+
 class RxBert {
 public:
     RxBert( int _PN );
-    ~RxBert();
      // tell thisl object to generate the next n bytes of the sequence
     %apply (char *STRING, int LENGTH) { (unsigned char *buffer, unsigned int bytes) };
     void check( unsigned char *buffer, unsigned int bytes );
+    void checkWithGap( unsigned char *buffer, unsigned int bytes, uint64_t missingBitsBefore );
+     // jump the reference to bit bitOffset of the pattern, or skip bits
+     // ahead of where it is now, without checking the data in between
+    void seek( uint64_t bitOffset );
+    void advance( uint64_t bits );
+    unsigned long getDroppedBits();
+
+     // bit position in the pattern period of the next byte, -1 if not synced
+    int64_t getPatternPosition();
      // controls
     void resetState();
+     // BERT_PN_AUTO to lock on whichever pattern is being sent
     void setPN( int PN );
     int getPN();
     unsigned long getBitsRX();
     unsigned long getBitsRXinSync();
     unsigned long getErrors();
     unsigned int synced();
-    unsigned long getSyncLossCount();            
+    unsigned long getSyncLossCount();
+    unsigned int getInverted();
+
+     // all of the above from one instant, safe from another thread while
+     // check() runs.  s = BertStats() then rx.snapshot( s )
+    void snapshot( BertStats *stats );
+     // declare sync after verifyBits matching bits instead of 88,
+     // 0 (the default) for the standard check
+    void setFastLock( unsigned int verifyBits );
+    unsigned int getFastLock();
+
+     // lock at high error rates, when verifyBits predicted from the
+     // data agree with it to 80% or better, 1024 is a good choice, 0
+     // (the default) for the standard check.  getSyncConfidence() rates the last lock.
+    void setCorrelationLock( unsigned int verifyBits );
+    unsigned int getCorrelationLock();
+    double getSyncConfidence();
+
+     // keep the reference running through a syncloss and look for the
+     // data again there, up to slipBits either way, before the cold
+     // search finds it.  Off by default.
+    void setFlywheel( unsigned int enable, unsigned int slipBits );
+    unsigned int getFlywheel();
+    unsigned long getOutageBits();
+    unsigned long getFlywheelResyncs();
+    int getResyncSlip();
+
+     // tell bit slips of up to maxSlip bits apart from syncloss, 0 (the
+     // default) for off
+    void setSlipDetect( unsigned int maxSlip );
+    unsigned int getSlipDetect();
+    unsigned long getInsertions();
+    unsigned long getDeletions();
+    unsigned long getInsertedBits();
+    unsigned long getDeletedBits();
+    unsigned long getLastSlipPosition();
+
+     // log the words with errors to a ring of events and histogram the burst
+     // lengths, errors less than burstGap bits apart are one burst, 0 events
+     // (the default) for off.  Read with ev = BertErrorEvent() and
+     // while rx.readErrorEvent( ev ): ...
+    void setErrorLog( unsigned int events, unsigned int burstGap );
+    unsigned int getErrorLog();
+    unsigned int readErrorEvent( BertErrorEvent *event );
+    unsigned long getErrorEventsLost();
+    unsigned long getBurstCount();
+    unsigned long getBurstHistogram( unsigned int bin );
+
+     // BER_ALARM when the BER over windowBits synced bits goes above
+     // threshold, BER_CLEAR when it is back, 0 threshold (the default) for off
+    void setBerAlarm( double threshold, uint64_t windowBits );
+    unsigned int getBerAlarm();
+
+     // G.821/G.826 errored, severely errored, error free and unavailable
+     // seconds, of bitsPerSecond line bits or of the wall clock.  sesBer is
+     // 1e-3 in G.821.  getIntervalBer() is the BER of the last second.
+    void setMetrics( unsigned int timeBase, uint64_t bitsPerSecond, double sesBer );
+    unsigned long getMetricSeconds();
+    unsigned long getErroredSeconds();
+    unsigned long getSeverelyErroredSeconds();
+    unsigned long getErrorFreeSeconds();
+    unsigned long getUnavailableSeconds();
+    double getIntervalBer();
+
+     // one sided confidence bounds on the BER so far, Clopper-Pearson (the
+     // default) or Wilson
+    void setConfidenceMethod( unsigned int method );
+    unsigned int getConfidenceMethod();
+    double getBerUpper( double confidence );
+    double getBerLower( double confidence );
+
+     // early stop: getBerVerdict() goes to PASS or FAIL once the BER is known
+     // to be below or above maxBer, or PRECISE once the interval is within
+     // relative of the estimate, and BERT_EVENT_VERDICT fires.  0 for off
+    void setBerTarget( double maxBer, double confidence );
+    void setBerPrecision( double relative, double confidence );
+    unsigned int getBerVerdict();
+
+     // declare syncloss when the last windowBits (rounded up to whole
+     // 64 bit words) have more than maxErrors bit errors in them, the
+     // window slides a word at a time
+    void setSyncLoss( unsigned int windowBits, unsigned int maxErrors );
+    unsigned int getSyncLossWindow();
+    unsigned int getSyncLossErrors();
+
+     // BERT_MSB_FIRST (default) or BERT_LSB_FIRST within each byte
+    void setBitOrder( unsigned int bitOrder );
+    unsigned int getBitOrder();
+
+     // synced buffers of 2 MB and up are checked on this many threads,
+     // 0 (the default) for one per CPU
+    void setThreads( unsigned int threads );
+    unsigned int getThreads();
+
+     // publish the snapshot() counters to the shared memory segment name as
+     // well, NULL or "" stops.  0 on success, -1 on failure
+    int setStatsPage( const char *name, uint64_t sampleBits );
 };
 
+%extend RxBert {
+     // fn( type, time, bitPosition, value ) for each BERT_EVENT_*, called from
+     // inside check().  time is CLOCK_MONOTONIC in ns, bitPosition the
+     // received bit it happened at.  None to stop.
+    void setEventCallback( PyObject *fn ) {
+        RxBertPythonRelease( $self );
+        if ( fn != Py_None ) {
+            Py_INCREF( fn );
+            $self->setEventCallback( RxBertPythonEvent, fn );
+        }
+    }
+
+    ~RxBert() {
+        RxBertPythonRelease( $self );
+        delete $self;
+    }
+};
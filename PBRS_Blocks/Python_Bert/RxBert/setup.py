@@ -8,7 +8,9 @@ from distutils.core import setup, Extension
 from distutils.core import setup, Extension
 from distutils.command.build_ext import build_ext
 
-copt =  { 'CXX' : ['-fopenmp','-O3','-ffast-math','-march=native']       }
+# no -march here, BertKernels.cpp picks its SIMD code at run time so the
+# same build works on every machine
+copt =  { 'CXX' : ['-fopenmp','-O3','-ffast-math']       }
 lopt =  {'CXX' : [''] }
 
 class build_ext_subclass( build_ext ):
@@ -24,7 +26,10 @@ class build_ext_subclass( build_ext ):
 
 
 RxBert_module = Extension('_RxBert',
-                           sources=['RxBert.cpp', 'RxBert_wrap.cpp'],
+                           sources=['RxBert.cpp', '../common/BertKernels.cpp', '../common/BertPattern.cpp',
+                                    '../common/BertThreads.cpp', '../common/BertShm.cpp', 'RxBert_wrap.cpp'],
+                           include_dirs=['../common'],
+                           libraries=['rt'],
                            )
 
 setup (name = 'RxBert',
@@ -1,9 +0,0 @@
-#ifndef __BertCommon_hpp
-#define __BertCommon_hpp
-
-// Defined Bert Patterns
-#define BERT_PN11 3
-#define BERT_PN15 4
-#define BERT_PN23 7
-
-#endif
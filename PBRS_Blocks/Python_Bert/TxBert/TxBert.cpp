@@ -5,13 +5,19 @@
    ITU O.150 document.
 
    Sequences we are generating:
-       PN11 --  2^11-1 test pattern
-       PN15 --  2^15-1 test pattern
-       PN23 -- 2^23-1 test pattern
+       PN7    --  2^7-1  test pattern
+       PN9    --  2^9-1  test pattern
+       PN11   --  2^11-1 test pattern
+       PN15   --  2^15-1 test pattern
+       PN20   --  2^20-1 test pattern
+       PN20SZ --  2^20-1 zero suppressed pattern
+       PN23   --  2^23-1 test pattern
+       PN31   --  2^31-1 test pattern
 
 */
 
 #include "TxBert.hpp"
+#include <stdlib.h>
 //#include <iostream>
 //#include <string.h>
 //#include <stdio.h>
@@ -20,6 +26,11 @@
        
 TxBert::TxBert( int _PN ) {
     //std::cout << "TxBert Setup Started.." << std::endl;
+    tableIndex = 0;
+    threads = 0;
+    statsPage = NULL;
+    statsName = NULL;
+    bitOrder = BERT_MSB_FIRST;
     setPN( _PN );
     resetState();
     //std::cout << "TxBert Setup Complete.. " << std::endl;
@@ -27,101 +38,259 @@ TxBert::TxBert( int _PN ) {
 
 TxBert::~TxBert() {
     //std::cout << "TxBert Teardown..\n";
+    setStatsPage( NULL, 0 );
 }
 
-unsigned int TxBert::getBitsTX() {
+uint64_t TxBert::getBitsTX() {
     return bitsTX;
 }
 
+// one bertParallel() job, the buffer cut into BERT_PARALLEL_CHUNK pieces
+struct TxBertChunks {
+    unsigned char *buffer;
+    unsigned int bytes;
+    const unsigned char *table;
+    unsigned int tableBytes;
+    unsigned int tableIndex;    // table byte for the start of the buffer
+    uint64_t reg;               // pattern word for the start of the buffer
+    const BertPatternDesc *pattern;
+    unsigned int bitOrder;
+};
+
+// copy n bytes of a period table starting at index, returns the new index
+static unsigned int copyTable( unsigned char *out, unsigned int n, const unsigned char *table,
+                               unsigned int tableBytes, unsigned int index ) {
+    unsigned int part;
+    while ( n != 0 ) {
+        part = tableBytes - index;
+        if ( part > n ) {
+            part = n;
+        }
+        memcpy( out, table + index, part );
+        out += part;
+        n -= part;
+        index += part;
+        if ( index == tableBytes ) {
+            index = 0;
+        }
+    }
+    return index;
+}
+
+static void fillChunk( void *arg, unsigned int chunk ) {
+    TxBertChunks *job = (TxBertChunks *) arg;
+    unsigned int offset = chunk * BERT_PARALLEL_CHUNK, n = job->bytes - offset;
+    uint64_t reg;
+    if ( n > BERT_PARALLEL_CHUNK ) {
+        n = BERT_PARALLEL_CHUNK;
+    }
+    if ( job->table != NULL ) {
+        copyTable( job->buffer + offset, n, job->table, job->tableBytes,
+                   (unsigned int) ((job->tableIndex + (uint64_t) offset) % job->tableBytes) );
+    } else {
+        // whole words only, the chunks are multiples of 8 bytes
+        reg = bertJumpWord( job->reg, bertJumpPoly( 8ULL * offset, job->pattern->order, job->pattern->tap ),
+                            job->pattern->order, job->pattern->tap );
+        bertFillWords( job->buffer + offset, n / 8, &reg, job->pattern, job->bitOrder );
+    }
+}
+
+// fill bytes from the table or from the word Reg across the worker pool,
+// returns 0 without doing anything if the buffer is too small to split
+int TxBert::fillParallel( unsigned char *buffer, unsigned int bytes ) {
+    TxBertChunks job;
+    unsigned int chunks = (bytes + BERT_PARALLEL_CHUNK - 1) / BERT_PARALLEL_CHUNK;
+
+    if ( (chunks < 2) || (bertThreadCount( threads ) <= 1) ) {
+        return 0;
+    }
+    job.buffer = buffer;
+    job.bytes = bytes;
+    job.table = table;
+    job.tableBytes = tableBytes;
+    job.tableIndex = tableIndex;
+    job.reg = Reg;
+    job.pattern = pattern;
+    job.bitOrder = bitOrder;
+    bertParallel( chunks, fillChunk, &job, threads );
+
+    if ( table != NULL ) {
+        tableIndex = (unsigned int) ((tableIndex + (uint64_t) bytes) % tableBytes);
+    } else {
+        Reg = bertJumpWord( Reg, bertJumpPoly( 8ULL * bytes, order, tap ), order, tap );
+    }
+    return 1;
+}
+
 // fills a buffer with the next N bytes of PN pattern.
+// Patterns with a full period table are copied straight out of it.
+// Otherwise the register is advanced 64 bits at a time and written out a
+// word at a time, only a partly used word at either end of the buffer goes
+// out byte by byte.
 void TxBert::fill( unsigned char *buffer, unsigned int bytes ) {
 
-    //unsigned int bytes = mb->size();
-    //unsigned char *buffer = mb->getDataPtr();
-
-    //std::cout << "Buffer Size = " << bytes << std::endl;
-
-    unsigned int offset;
-    unsigned int RegA, RegB;
-    unsigned char byteOut;
-    for ( offset = 0; offset < bytes; offset++) {
-        switch (PN) {
-            case BERT_PN11:
-                ///// process for doing a PN11
-                // get the current byte
-                Reg = Reg & 0x7ff; // mask shift register
-                byteOut = (unsigned char) ( Reg & 0xFF );
-                //std::cout << "Byte Out: " << std::hex << (int)byteOut << std::endl;
-                // compute the next byte
-                // nibble 1
-                //std::cout << "Reg: " << Reg;
-                RegA = (Reg & 0x000000FF);  // mask first 8 feed back tap 1
-                RegB = (Reg & 0x000003FC) >> 2;  // mask second 8 feed back tap 2
-                //std::cout << " RegA: " << RegA << " RegB: " << RegB;
-                RegB = (RegA) ^ (RegB);
-                //std::cout << " RegA^RegB: " << RegB;
-                RegB = RegB << 11;
-                //std::cout << " Feedback: " << RegB << std::dec << std::endl;
-                Reg = Reg + RegB; // add feedback to front of Reg
-                Reg = Reg >> 8;
-                break;
-            case BERT_PN15:
-                ////// process for doing a PN15 pattern
-                Reg = Reg & 0x7FFF;
-                byteOut = (unsigned char) ( Reg & 0xFF );
-                RegA = (Reg & 0x000000FF); // mask first 8 states for feedback tap 1
-                RegB = (Reg & 0x000001FE) >> 1; // mask first 8 states for feedback tap 2
-                // Compute feedback for next 8 states
-                RegB = (RegB) ^ (RegA);
-                RegB = RegB << 15;
-                Reg = Reg + RegB;
-                // shift 8 state to setup for next pass
-                Reg = Reg >> 8;
-                break;
-            case BERT_PN23:
-                ///// process for doing a PN23
-                Reg = Reg & 0x7FFFFF;
-                byteOut = (unsigned char) ( Reg & 0xFF );
-                // compute the next byte
-                RegA = (Reg & 0x000000FF);  // mask first 8 feed back tap 1
-                RegB = (Reg & 0x00001FE0) >> 5;  // mask second 8 feed back tap 2
-                RegB = (RegB)^(RegA);
-                RegB = RegB << 23; // shift so bits 12->15 are the next nibble feedback
-                Reg = Reg + RegB; // add feedback to front of Reg
-                Reg = Reg >> 8;
-                break;    
-            default:
-                byteOut = 0xFF;
-                break;
+    unsigned int offset = 0, words;
+    uint64_t wordOut;
+
+    if ( table != NULL ) {
+        if ( !fillParallel( buffer, bytes ) ) {
+            tableIndex = copyTable( buffer, bytes, table, tableBytes, tableIndex );
+        }
+        bitsTX = bitsTX + 8ULL * bytes;
+        publishStats();
+        return;
+    }
+
+    // finish the word left over from the last call
+    if ( regBytes != 0 ) {
+        wordOut = bertWireWord( bertOutputWord( Reg, pattern ), bitOrder ) >> (8 * regBytes);
+        while ( (regBytes < 8) && (offset < bytes) ) {
+            buffer[offset++] = (unsigned char) wordOut;
+            wordOut = wordOut >> 8;
+            regBytes++;
         }
-        // fast flip bit order.
-        // this works on 32bit (and 64bit) processors only.
-        byteOut = ((byteOut * 0x80200802ULL) & 0x0884422110ULL) * 0x0101010101ULL >> 32;
-        //std::cout << "offset = " << offset << std::endl;
-        buffer[offset] = byteOut;
-        bitsTX = bitsTX+8;
+        if ( regBytes == 8 ) {
+            nextWord();
+        }
+    }
+
+    // whole words, through the vector kernels where the CPU has them
+    words = (bytes - offset) / 8;
+    if ( !fillParallel( buffer + offset, 8 * words ) ) {
+        bertFillWords( buffer + offset, words, &Reg, pattern, bitOrder );
+    }
+    offset += 8 * words;
+
+    // start on the next word with whatever is left
+    if ( offset < bytes ) {
+        wordOut = bertWireWord( bertOutputWord( Reg, pattern ), bitOrder );
+        while ( offset < bytes ) {
+            buffer[offset++] = (unsigned char) wordOut;
+            wordOut = wordOut >> 8;
+            regBytes++;
+        }
+    }
+
+    bitsTX = bitsTX + 8ULL * bytes;
+    publishStats();
+}
+
+// step the register to the next 64 bits of the pattern
+void TxBert::nextWord() {
+    Reg = bertNextWord( Reg, order, tap );
+    regBytes = 0;
+}
+
+// move the generator so the next bit sent is bit bitOffset of the pattern,
+// counted from resetState().  O(log bitOffset) through the GF(2) jump.
+void TxBert::seek( uint64_t bitOffset ) {
+    if ( table != NULL ) {
+        tableIndex = bertPatternByte( bitOffset, order );
+    } else {
+        Reg = bertJumpWord( bertSeedWord( 0xFFFFFFFF, order, tap ), bertJumpPoly( bitOffset, order, tap ), order, tap );
+        regBytes = 0;
+    }
+}
+
+// skip the next bits of the pattern without generating them
+void TxBert::advance( uint64_t bits ) {
+    if ( table != NULL ) {
+        tableIndex = bertPatternByte( 8ULL * tableIndex + bits % ((1ULL << order) - 1), order );
+    } else {
+        Reg = bertJumpWord( Reg, bertJumpPoly( 8ULL * regBytes + bits, order, tap ), order, tap );
+        regBytes = 0;
     }
 }
 
 void TxBert::resetState() {
     // reset registers to all ones
-    Reg = 0xFFFFFFFF;
+    Reg = bertSeedWord( 0xFFFFFFFF, order, tap );
+    regBytes = 0;
+    tableIndex = 0;
 
     // reset number of bits transmitted
     bitsTX = 0;
+    publishStats();
 }
 
 void TxBert::setPN( int _PN ) {
-    if ( (_PN > 0) && ( _PN < 7) ) {
+    pattern = bertDescriptor( _PN );
+    if ( pattern != NULL ) {
         // valid PN Selected
         PN = _PN;
     } else {
-        //std::cout << "TxBert::setPN: Unknown PN Pattern " << PN << " Selected, defaulting to PN9\n";
+        //std::cout << "TxBert::setPN: Unknown PN Pattern " << PN << " Selected, defaulting to PN11\n";
         PN = BERT_PN11;
+        pattern = bertDescriptor( PN );
     }
+    order = pattern->order;
+    tap = pattern->tap;
+
+    // shared full period table, NULL for patterns too long to cache.  The
+    // register of the old pattern is no use to the new one, it carries on
+    // from the table position, or from all ones without a table.
+    table = bertPatternTable( pattern, bitOrder, &tableBytes );
+    if ( table != NULL ) {
+        tableIndex = tableIndex % tableBytes;
+        Reg = bertJumpWord( bertSeedWord( 0xFFFFFFFF, order, tap ), bertJumpPoly( 8ULL * tableIndex, order, tap ),
+                            order, tap );
+    } else {
+        Reg = bertSeedWord( 0xFFFFFFFF, order, tap );
+    }
+    regBytes = 0;
 }
 
 int TxBert::getPN() {
     return PN;
 }
 
+// order of the bits within each byte, BERT_MSB_FIRST (the default) sends
+// the first bit of the pattern in bit 7, BERT_LSB_FIRST in bit 0
+void TxBert::setBitOrder( unsigned int bitOrder ) {
+    this->bitOrder = (bitOrder == BERT_LSB_FIRST) ? BERT_LSB_FIRST : BERT_MSB_FIRST;
+    // same positions, the table for the other bit order
+    table = bertPatternTable( pattern, this->bitOrder, &tableBytes );
+}
+
+unsigned int TxBert::getBitOrder() {
+    return bitOrder;
+}
+
+// threads used for large buffers, 0 for one per CPU, 1 to stay serial
+void TxBert::setThreads( unsigned int threads ) {
+    this->threads = threads;
+}
+
+unsigned int TxBert::getThreads() {
+    return threads;
+}
+
+int TxBert::setStatsPage( const char *name, uint64_t sampleBits ) {
+    bertShmDestroy( statsPage, statsName );
+    free( statsName );
+    statsPage = NULL;
+    statsName = NULL;
+    if ( (name == NULL) || (name[0] == 0) ) {
+        return 0;
+    }
+    statsPage = bertShmCreate( name, BERT_SHM_TX, sampleBits );
+    if ( statsPage == NULL ) {
+        return -1;
+    }
+    statsName = strdup( name );
+    publishStats();
+    return 0;
+}
+
+void TxBert::publishStats() {
+    if ( statsPage == NULL ) {
+        return;
+    }
+    bertShmBegin( statsPage );
+    statsPage->PN = PN;
+    statsPage->bitOrder = bitOrder;
+    statsPage->bits = bitsTX;
+    bertShmSample( statsPage );
+    bertShmEnd( statsPage );
+}
+
@@ -5,12 +5,14 @@
    Peter R Fetterer <Peter.R.Fetterer@nasa.gov>
 
    Sequences we are generating:
-       PN9  --  2^9-1  test pattern
-       PN11 --  2^11-1 test pattern
-       PN15 --  2^15-1 test pattern
-       PN20TS -- 2^20-1 Test Sequence
+       PN7    -- 2^7-1  test pattern
+       PN9    -- 2^9-1  test pattern
+       PN11   -- 2^11-1 test pattern
+       PN15   -- 2^15-1 test pattern
+       PN20   -- 2^20-1 Test Sequence
        PN20SZ -- 2^20-1 Zero Suppressed Pattern
        PN23   -- 2^23-1 test pattern
+       PN31   -- 2^31-1 test pattern
 
 */
 
@@ -27,16 +29,50 @@ class TxBert {
         // tell thisl object to generate the next n bytes of the sequence
         void fill( unsigned char *buffer, unsigned int bytes );
 
+        // jump the generator to bit bitOffset of the pattern, or skip bits
+        // ahead of where it is now, without generating the data in between
+        void seek( uint64_t bitOffset );
+        void advance( uint64_t bits );
+
         // controls
         void resetState();
         void setPN( int PN );
         int getPN();
-        unsigned int getBitsTX();
+        uint64_t getBitsTX();
+
+        // BERT_MSB_FIRST (default) or BERT_LSB_FIRST within each byte
+        void setBitOrder( unsigned int bitOrder );
+        unsigned int getBitOrder();
+
+        // buffers of 2 MB and up are filled on this many threads,
+        // 0 (the default) for one per CPU
+        void setThreads( unsigned int threads );
+        unsigned int getThreads();
+
+        // publish the counters to the shared memory segment name after
+        // every fill(), with a sample for the history every sampleBits.
+        // NULL or "" stops.  0 on success, -1 if it could not be created.
+        int setStatsPage( const char *name, uint64_t sampleBits );
 
     private:
+        void nextWord();
+        int fillParallel( unsigned char *buffer, unsigned int bytes );
+        void publishStats();
+
         unsigned int PN;
-        unsigned int Reg;
-        unsigned int bitsTX;
+        const BertPatternDesc *pattern;
+        unsigned int order;     // register length of the selected pattern
+        unsigned int tap;       // feedback tap of the selected pattern
+        uint64_t Reg;           // next 64 bits of the pattern
+        unsigned int regBytes;  // bytes of Reg already sent
+        const unsigned char *table;  // full period table, NULL if not cached
+        unsigned int tableBytes;
+        unsigned int tableIndex;     // next table byte to send
+        uint64_t bitsTX;
+        unsigned int threads;
+        unsigned int bitOrder;  // BERT_MSB_FIRST or BERT_LSB_FIRST
+        BertShmPage *statsPage; // NULL unless setStatsPage()
+        char *statsName;
 };        
         
 #endif
@@ -1,9 +1,24 @@
 %module TxBert
 %include typemaps.i
+%include stdint.i
 %{
 #include "TxBert.hpp"
 %}
 
+// pattern numbers for setPN()
+#define BERT_PN7    1
+#define BERT_PN9    2
+#define BERT_PN11   3
+#define BERT_PN15   4
+#define BERT_PN20   5
+#define BERT_PN20SZ 6
+#define BERT_PN23   7
+#define BERT_PN31   8
+
+// bit orders for setBitOrder()
+#define BERT_MSB_FIRST 0
+#define BERT_LSB_FIRST 1
+
 class TxBert {
     public:
         TxBert( int _PN );
@@ -13,11 +28,29 @@ class TxBert {
         %apply (char *STRING, int LENGTH) { (unsigned char *buffer, unsigned int bytes) };
         void fill( unsigned char *buffer, unsigned int bytes );
 
+        // jump the generator to bit bitOffset of the pattern, or skip bits
+        // ahead of where it is now, without generating the data in between
+        void seek( uint64_t bitOffset );
+        void advance( uint64_t bits );
+
         // controls
         void resetState();
         void setPN( int PN );
         int getPN();
-        unsigned int getBitsTX();
+        uint64_t getBitsTX();
+
+        // BERT_MSB_FIRST (default) or BERT_LSB_FIRST within each byte
+        void setBitOrder( unsigned int bitOrder );
+        unsigned int getBitOrder();
+
+        // buffers of 2 MB and up are filled on this many threads,
+        // 0 (the default) for one per CPU
+        void setThreads( unsigned int threads );
+        unsigned int getThreads();
+
+        // publish the counters to the shared memory segment name after
+        // every fill(), NULL or "" stops.  0 on success, -1 on failure
+        int setStatsPage( const char *name, uint64_t sampleBits );
 
 };              
 
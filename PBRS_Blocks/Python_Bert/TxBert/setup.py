@@ -8,7 +8,10 @@ from distutils.core import setup, Extension
 
 
 TxBert_module = Extension('_TxBert',
-                           sources=['TxBert.cpp', 'TxBert_wrap.cpp'],
+                           sources=['TxBert.cpp', '../common/BertKernels.cpp', '../common/BertPattern.cpp',
+                                    '../common/BertThreads.cpp', '../common/BertShm.cpp', 'TxBert_wrap.cpp'],
+                           include_dirs=['../common'],
+                           libraries=['rt'],
                            )
 
 setup (name = 'TxBert',
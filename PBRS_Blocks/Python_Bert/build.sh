@@ -6,6 +6,7 @@ cd TxBert
 ./build.sh
 cd ..
 
+mkdir -p ./modules
 cp -v ./RxBert/build/lib.linux-x86_64-2.7/* ./modules/
 rm ./RxBert/build/lib.linux-x86_64-2.7/*
 cp -v ./TxBert/build/lib.linux-x86_64-2.7/* ./modules/
@@ -0,0 +1,374 @@
+#ifndef __BertCommon_hpp
+#define __BertCommon_hpp
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Defined Bert Patterns
+#define BERT_PN7    1
+#define BERT_PN9    2
+#define BERT_PN11   3
+#define BERT_PN15   4
+#define BERT_PN20   5
+#define BERT_PN20SZ 6
+#define BERT_PN23   7
+#define BERT_PN31   8
+#define BERT_PN_MAX 8
+
+// RxBert::setPN(), find the pattern being sent instead of naming it
+#define BERT_PN_AUTO 0
+
+// All ITU O.150 patterns are trinomials x^order + x^tap + 1, which gives
+// the recurrence s[n] = s[n-order] ^ s[n-tap] on the serial bit stream.
+//
+// The word kernels below hold 64 consecutive stream bits in a uint64_t,
+// oldest bit in bit 0 (s[n+j] in bit j).  Byte k of the buffer carries
+// stream bits 8k..8k+7, in bit 7..0 when the wire is MSB first (the
+// default) or in bit 0..7 when it is LSB first.  LSB first is simply the
+// word stored little endian, MSB first needs the bits of every byte
+// reversed.
+#define BERT_MSB_FIRST 0
+#define BERT_LSB_FIRST 1
+
+// every supported pattern as X( PN, name, order, tap, invert, zero
+// suppress ).  The descriptors below and the per pattern kernels in
+// BertKernels.cpp are all expanded from this one list, so a new pattern
+// only needs a line here.
+//
+// PN11, PN15 and PN23 have always been sent true by this module and stay
+// that way, PN31 is inverted as O.150 asks.  PN20SZ is the zero
+// suppressed 2^20-1 sequence (QRSS), no more than 14 zeros in a row.
+#define BERT_PATTERNS(X) \
+    X( BERT_PN7,    "PN7",    7,  6, 0, 0 ) \
+    X( BERT_PN9,    "PN9",    9,  5, 0, 0 ) \
+    X( BERT_PN11,   "PN11",  11,  9, 0, 0 ) \
+    X( BERT_PN15,   "PN15",  15, 14, 0, 0 ) \
+    X( BERT_PN20,   "PN20",  20,  3, 0, 0 ) \
+    X( BERT_PN20SZ, "PN20SZ", 20, 17, 0, 1 ) \
+    X( BERT_PN23,   "PN23",  23, 18, 0, 0 ) \
+    X( BERT_PN31,   "PN31",  31, 28, 1, 0 )
+
+// one pattern, everything the generator and checker need to know about it
+struct BertPatternDesc {
+    int PN;
+    const char *name;
+    unsigned int order;         // register length
+    unsigned int tap;           // feedback tap
+    uint64_t invert;            // all ones if the pattern is sent inverted
+    unsigned int zeroSuppress;  // a one is forced ahead of 14 zeros
+};
+
+static const BertPatternDesc bertPatternList[] = {
+#define BERT_DESC_ENTRY( pn, name, o, t, inv, zs ) \
+    { (pn), (name), (o), (t), (inv) ? 0xFFFFFFFFFFFFFFFFULL : 0ULL, (zs) },
+    BERT_PATTERNS( BERT_DESC_ENTRY )
+#undef BERT_DESC_ENTRY
+};
+
+// look up the descriptor for a pattern, NULL if unknown
+static inline const BertPatternDesc *bertDescriptor( int PN ) {
+    unsigned int n;
+    for ( n = 0; n < sizeof(bertPatternList) / sizeof(bertPatternList[0]); n++ ) {
+        if ( bertPatternList[n].PN == PN ) {
+            return &bertPatternList[n];
+        }
+    }
+    return NULL;
+}
+
+// given the 64 stream bits s[n..n+63], compute s[n+64..n+127].
+// The first pass pulls the feedback terms that land in the old word, the
+// rest is next = A / (1 + x^tap + x^order) truncated to 64 bits, done as a
+// product of (1 + y^(2^i)) factors.  PN11 and PN15 need 3 passes, PN23 2.
+static inline uint64_t bertNextWord( uint64_t w, unsigned int order, unsigned int tap ) {
+    uint64_t a = (w >> (64 - order)) ^ (w >> (64 - tap));
+    unsigned int t, o;
+    for ( t = tap, o = order; t < 64; t <<= 1, o <<= 1 ) {
+        uint64_t b = a ^ (a << t);
+        if ( o < 64 ) {
+            b ^= a << o;
+        }
+        a = b;
+    }
+    return a;
+}
+
+// expand an order bit register (s[n] in bit 0) to the 64 stream bits s[n..n+63]
+static inline uint64_t bertSeedWord( uint64_t reg, unsigned int order, unsigned int tap ) {
+    uint64_t w = reg & ((1ULL << order) - 1);
+    unsigned int n;
+    for ( n = order; n < 64; n++ ) {
+        w |= (((w >> (n - order)) ^ (w >> (n - tap))) & 1ULL) << n;
+    }
+    return w;
+}
+
+// LFSR core with the register order, tap and inversion fixed at compile
+// time.  Code written against this, rather than against run time order
+// and tap, gets the word step unrolled and every shift and mask folded to
+// a constant.
+template <unsigned int Order, unsigned int Tap, bool Invert = false>
+struct BertLfsr {
+    static_assert( (Tap > 0) && (Tap < Order) && (Order < 64), "not a valid pattern" );
+    static constexpr unsigned int order = Order;
+    static constexpr unsigned int tap = Tap;
+    static constexpr uint64_t mask = (1ULL << Order) - 1;
+    static constexpr uint64_t invert = Invert ? 0xFFFFFFFFFFFFFFFFULL : 0ULL;
+
+    static inline uint64_t next( uint64_t w ) {
+        return bertNextWord( w, Order, Tap );
+    }
+};
+
+// the same interface for a pattern picked at run time, the fallback for
+// an order and tap that are not in BERT_PATTERNS
+struct BertLfsrRuntime {
+    unsigned int order;
+    unsigned int tap;
+    uint64_t mask;
+    uint64_t invert;
+
+    BertLfsrRuntime( unsigned int _order, unsigned int _tap, uint64_t _invert )
+        : order( _order ), tap( _tap ), mask( (1ULL << _order) - 1 ), invert( _invert ) {}
+
+    inline uint64_t next( uint64_t w ) const {
+        return bertNextWord( w, order, tap );
+    }
+};
+
+// multiply two polynomials mod the characteristic polynomial of the
+// pattern, x^order + x^(order-tap) + 1.  Both inputs have degree < order.
+static inline uint64_t bertPolyMulMod( uint64_t a, uint64_t b, unsigned int order, unsigned int tap ) {
+    uint64_t p = 0, poly = (1ULL << order) | (1ULL << (order - tap)) | 1ULL;
+    while ( b != 0 ) {
+        if ( b & 1 ) {
+            p ^= a;
+        }
+        a <<= 1;
+        if ( a & (1ULL << order) ) {
+            a ^= poly;
+        }
+        b >>= 1;
+    }
+    return p;
+}
+
+// x^bits mod the characteristic polynomial, the jump-ahead operator for
+// a skip of that many bits.  Square and multiply, O(log bits).
+static inline uint64_t bertJumpPoly( uint64_t bits, unsigned int order, unsigned int tap ) {
+    uint64_t result = 1, base = 2;
+    while ( bits != 0 ) {
+        if ( bits & 1 ) {
+            result = bertPolyMulMod( result, base, order, tap );
+        }
+        base = bertPolyMulMod( base, base, order, tap );
+        bits >>= 1;
+    }
+    return result;
+}
+
+// apply a jump operator from bertJumpPoly to the stream word s[n..n+63].
+// With x^k = sum c_i x^i we have s[n+k+j] = sum c_i s[n+i+j], which only
+// needs stream bits up to 2*order-2, so this covers orders up to 32.
+static inline uint64_t bertJumpWord( uint64_t w, uint64_t jump, unsigned int order, unsigned int tap ) {
+    uint64_t reg = 0;
+    while ( jump != 0 ) {
+        reg ^= w >> __builtin_ctzll( jump );
+        jump &= jump - 1;
+    }
+    return bertSeedWord( reg, order, tap );
+}
+
+// the bits sent for the stream word w, after the pattern's inversion or
+// zero suppression.  Suppression forces a bit to one when the 14 stream
+// bits after it are all zero, so it looks into the next word.
+static inline uint64_t bertOutputWord( uint64_t w, const BertPatternDesc *p ) {
+    unsigned __int128 v;
+    if ( p->zeroSuppress ) {
+        v = ((unsigned __int128) bertNextWord( w, p->order, p->tap ) << 64) | w;
+        // bit j becomes the OR of bits j..j+13
+        v |= v >> 1;
+        v |= v >> 2;
+        v |= v >> 4;
+        v |= v >> 6;
+        w |= ~(uint64_t) (v >> 1);
+    }
+    return w ^ p->invert;
+}
+
+// reverse the bit order inside every byte of a word
+static inline uint64_t bertReverseBytes( uint64_t w ) {
+    w = ((w >> 1) & 0x5555555555555555ULL) | ((w & 0x5555555555555555ULL) << 1);
+    w = ((w >> 2) & 0x3333333333333333ULL) | ((w & 0x3333333333333333ULL) << 2);
+    w = ((w >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((w & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return w;
+}
+
+// stream word to buffer word or back for a wire bit order
+static inline uint64_t bertWireWord( uint64_t w, unsigned int bitOrder ) {
+    return (bitOrder == BERT_MSB_FIRST) ? bertReverseBytes( w ) : w;
+}
+
+// unaligned little endian word access, byte k of the buffer is byte k of the word
+static inline uint64_t bertLoad64( const unsigned char *p ) {
+    uint64_t w;
+    memcpy( &w, p, sizeof(w) );
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    w = __builtin_bswap64( w );
+#endif
+    return w;
+}
+
+static inline void bertStore64( unsigned char *p, uint64_t w ) {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    w = __builtin_bswap64( w );
+#endif
+    memcpy( p, &w, sizeof(w) );
+}
+
+// bulk kernels, BertKernels.cpp.  These pick scalar, SSE4.2, AVX2 or
+// AVX-512 code the first time they are called, based on the CPU they run
+// on, and then the copy of that code built for the pattern's BertLfsr.
+// Both work on whole 64 bit words starting from the stream word *reg and
+// leave *reg on the word after the last one processed.
+
+// *reg is the raw LFSR stream, inversion and zero suppression are applied
+// on the way out.  bitOrder is BERT_MSB_FIRST or BERT_LSB_FIRST.
+
+// write words of pattern to out
+void bertFillWords( unsigned char *out, size_t words, uint64_t *reg, const BertPatternDesc *p, unsigned int bitOrder );
+
+// compare words of in against the pattern, returns the number of bit errors
+uint64_t bertCheckWords( const unsigned char *in, size_t words, uint64_t *reg, const BertPatternDesc *p,
+                         unsigned int bitOrder );
+
+// number of bits that differ between a and b
+uint64_t bertDiffBits( const unsigned char *a, const unsigned char *b, size_t bytes );
+
+// reverse the bits of every byte, in may be the same buffer as out
+void bertReverseBits( unsigned char *out, const unsigned char *in, size_t bytes );
+
+// name of the kernel set in use, "scalar", "sse4.2", "avx2" or "avx512"
+const char *bertKernelName();
+
+// full period pattern tables, BertPattern.cpp.
+// A pattern of period p = 2^order-1 bits repeats on a byte boundary after
+// 8 periods, so p bytes hold the whole byte stream.  The table starts at
+// the all ones register and is followed by 8 pad bytes repeating its
+// start, so 8 byte reads may run up to p+7.  Tables are built on first use,
+// one per wire bit order, and shared by every object of the module that
+// built them.  _TxBert and _RxBert each link their own copy of these
+// sources, so a process loading both builds every table it uses, and
+// starts a worker pool, once per module.
+#ifndef BERT_TABLE_MAX_ORDER
+#define BERT_TABLE_MAX_ORDER 23
+#endif
+
+// returns NULL for patterns longer than BERT_TABLE_MAX_ORDER
+const unsigned char *bertPatternTable( const BertPatternDesc *p, unsigned int bitOrder, unsigned int *bytes );
+
+// bit position within the period of the raw order bit register reg (s[n]
+// in bit 0), counted from the all ones register.  Returns -1 for a
+// register that is not part of the pattern (all zeros).  Patterns without
+// a table take a baby-step giant-step search, a few ms for PN31.
+int64_t bertPatternLocate( const BertPatternDesc *p, uint64_t reg );
+
+// table byte that starts with stream bit position bit of the pattern
+static inline unsigned int bertPatternByte( uint64_t bit, unsigned int order ) {
+    uint64_t period = (1ULL << order) - 1;
+    bit = bit % period;
+    // period is odd, so exactly one of the 8 repeats of bit is byte aligned
+    while ( bit & 7 ) {
+        bit += period;
+    }
+    return (unsigned int) (bit >> 3);
+}
+
+// worker pool, BertThreads.cpp.
+// fill() and check() calls of at least two chunks are split across the
+// pool, each chunk starting from a jump-ahead of the register.
+#define BERT_PARALLEL_CHUNK (1024 * 1024)
+
+// run fn(arg, chunk) for every chunk in [0, chunks) on up to threads
+// threads, the caller included, and return once all of them are done
+void bertParallel( unsigned int chunks, void (*fn)( void *arg, unsigned int chunk ), void *arg, unsigned int threads );
+
+// threads used for a thread setting, 0 meaning one per online CPU
+unsigned int bertThreadCount( unsigned int threads );
+
+// shared memory stats page, BertShm.cpp.
+// A TxBert or RxBert with setStatsPage() publishes its counters into the
+// named POSIX shared memory segment (/dev/shm/<name> on Linux) after every
+// fill() or check() call, so a monitor in another process can map it and
+// read it without making a system call per sample.
+//
+// The page is written by one thread and never locked.  seq is odd while
+// it is being updated: a reader copies what it needs between two reads of
+// seq and keeps the copy when both were the same even number.  Readers
+// check magic, version and size before anything else; fields are only
+// ever added at the end, with version bumped.
+//
+// history[] is a ring of BERT_SHM_HISTORY samples of the counters, one
+// every sampleBits bits, for plotting BER over time.  samples is the
+// number ever written, the newest is history[(samples - 1) % BERT_SHM_HISTORY].
+#define BERT_SHM_MAGIC   0x54524542     // "BERT"
+#define BERT_SHM_VERSION 1
+#define BERT_SHM_HISTORY 1024
+#define BERT_SHM_TX      1
+#define BERT_SHM_RX      2
+
+struct BertShmSample {
+    uint64_t time;          // CLOCK_MONOTONIC, ns
+    uint64_t bits;          // bits sent or received so far
+    uint64_t bitsInSync;
+    uint64_t errors;
+};
+
+struct BertShmPage {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;          // sizeof(BertShmPage)
+    uint32_t role;          // BERT_SHM_TX or BERT_SHM_RX
+    uint64_t seq;
+    int32_t PN;
+    uint32_t synced;
+    uint32_t inverted;
+    uint32_t bitOrder;
+    uint64_t bits;          // bitsTX or bitsRX
+    uint64_t bitsInSync;
+    uint64_t errors;
+    uint64_t syncLossCount;
+    uint64_t droppedBits;
+    uint64_t outageBits;
+    uint64_t sampleBits;
+    uint64_t samples;
+    BertShmSample history[BERT_SHM_HISTORY];
+};
+
+// create the segment, or take over one left by an earlier run, and map it.
+// NULL if it could not be.
+BertShmPage *bertShmCreate( const char *name, unsigned int role, uint64_t sampleBits );
+
+// unmap the segment and remove the name, monitors that have it mapped keep
+// the last values
+void bertShmDestroy( BertShmPage *page, const char *name );
+
+// writer side, around an update of the counters
+void bertShmBegin( BertShmPage *page );
+void bertShmEnd( BertShmPage *page );
+
+// add a history sample if sampleBits have gone by since the last one,
+// between bertShmBegin() and bertShmEnd()
+void bertShmSample( BertShmPage *page );
+
+// monitor side, map an existing segment read only, NULL if there is none
+// or its layout is not this one
+const BertShmPage *bertShmAttach( const char *name );
+void bertShmDetach( const BertShmPage *page );
+
+// consistent copy of the counters, everything before history[].  Returns 1
+// when copied, 0 if the page was written through every try.
+int bertShmRead( const BertShmPage *page, BertShmPage *out );
+
+#endif
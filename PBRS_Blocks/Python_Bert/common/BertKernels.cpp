@@ -0,0 +1,650 @@
+/* BertKernels
+   Bulk PN pattern generate and compare kernels shared by TxBert and RxBert.
+
+   The vector kernels run one independent piece of the pattern per 64 bit
+   lane.  The buffer is cut into one segment per lane and every lane starts
+   from the register jumped ahead to its segment (bertJumpWord), so all
+   lanes step with the same shifts.  Groups of words are transposed back
+   into buffer order before they are stored or compared.
+
+   The kernel set is picked at run time from the CPU features, so a module
+   built without -march flags still uses AVX2 or AVX-512 where it can.
+   Setting BERT_KERNELS=scalar|sse4.2|avx2|avx512 in the environment caps
+   the choice, which is handy for testing the slower paths.
+*/
+
+#include "BertCommon.hpp"
+#include <stdlib.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define BERT_X86_KERNELS 1
+#endif
+
+// lane start registers for a split of words into lanes segments of a
+// multiple of group words each.  Returns the segment length, 0 if the
+// buffer is too small to be worth splitting.
+static size_t bertLanes( uint64_t reg, size_t words, unsigned int lanes, unsigned int group,
+                         uint64_t *start, unsigned int order, unsigned int tap ) {
+    size_t seg = (words / lanes) / group * group;
+    uint64_t jump;
+    unsigned int l;
+
+    if ( (seg < 4 * group) || (order > 32) ) {
+        return 0;
+    }
+    jump = bertJumpPoly( (uint64_t) seg * 64, order, tap );
+    start[0] = reg;
+    for ( l = 1; l < lanes; l++ ) {
+        start[l] = bertJumpWord( start[l-1], jump, order, tap );
+    }
+    return seg;
+}
+
+// Every kernel is a template on the LFSR (a BertLfsr, or BertLfsrRuntime
+// for a pattern that is not in BERT_PATTERNS).  With a BertLfsr the shift
+// counts are compile time constants and the step loops unroll into
+// immediate shifts.  Zero suppressed patterns need to see past the word
+// they are writing and only get the scalar loops at the bottom.
+
+////// scalar
+
+template <bool Msb, class L>
+static void fillScalar( unsigned char *out, size_t words, uint64_t *reg, const L &lfsr ) {
+    uint64_t w = *reg;
+    size_t i;
+    for ( i = 0; i < words; i++ ) {
+        bertStore64( out + 8 * i, Msb ? bertReverseBytes( w ^ lfsr.invert ) : w ^ lfsr.invert );
+        w = lfsr.next( w );
+    }
+    *reg = w;
+}
+
+template <bool Msb, class L>
+static uint64_t checkScalar( const unsigned char *in, size_t words, uint64_t *reg, const L &lfsr ) {
+    uint64_t w = *reg, errors = 0;
+    size_t i;
+    for ( i = 0; i < words; i++ ) {
+        errors += __builtin_popcountll( w ^ lfsr.invert ^ (Msb ? bertReverseBytes( bertLoad64( in + 8 * i ) )
+                                                             : bertLoad64( in + 8 * i )) );
+        w = lfsr.next( w );
+    }
+    *reg = w;
+    return errors;
+}
+
+static uint64_t diffScalar( const unsigned char *a, const unsigned char *b, size_t bytes ) {
+    uint64_t errors = 0;
+    size_t i;
+    for ( i = 0; i + 8 <= bytes; i += 8 ) {
+        errors += __builtin_popcountll( bertLoad64( a + i ) ^ bertLoad64( b + i ) );
+    }
+    for ( ; i < bytes; i++ ) {
+        errors += __builtin_popcount( a[i] ^ b[i] );
+    }
+    return errors;
+}
+
+static void reverseScalar( unsigned char *out, const unsigned char *in, size_t bytes ) {
+    size_t i;
+    for ( i = 0; i + 8 <= bytes; i += 8 ) {
+        bertStore64( out + i, bertReverseBytes( bertLoad64( in + i ) ) );
+    }
+    for ( ; i < bytes; i++ ) {
+        out[i] = (unsigned char) bertReverseBytes( in[i] );
+    }
+}
+
+#ifdef BERT_X86_KERNELS
+
+////// SSE4.2, 2 lanes
+
+#define BERT_SSE __attribute__((target("sse4.2,popcnt")))
+
+// bertNextWord on every lane, shifts of 64 or more give zero
+template <class L>
+BERT_SSE static inline __m128i nextSse( __m128i w, const L &lfsr ) {
+    __m128i a = _mm_xor_si128( _mm_srli_epi64( w, 64 - lfsr.order ), _mm_srli_epi64( w, 64 - lfsr.tap ) );
+    unsigned int t, o;
+    for ( t = lfsr.tap, o = lfsr.order; t < 64; t <<= 1, o <<= 1 ) {
+        a = _mm_xor_si128( a, _mm_xor_si128( _mm_slli_epi64( a, t ), _mm_slli_epi64( a, o ) ) );
+    }
+    return a;
+}
+
+BERT_SSE static inline __m128i reverseSse( __m128i v ) {
+    const __m128i lo = _mm_setr_epi8( 0x00, (char) 0x80, 0x40, (char) 0xC0, 0x20, (char) 0xA0, 0x60, (char) 0xE0,
+                                      0x10, (char) 0x90, 0x50, (char) 0xD0, 0x30, (char) 0xB0, 0x70, (char) 0xF0 );
+    const __m128i hi = _mm_setr_epi8( 0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF );
+    const __m128i mask = _mm_set1_epi8( 0x0F );
+    return _mm_or_si128( _mm_shuffle_epi8( lo, _mm_and_si128( v, mask ) ),
+                         _mm_shuffle_epi8( hi, _mm_and_si128( _mm_srli_epi16( v, 4 ), mask ) ) );
+}
+
+// reverse for MSB first wire order, nothing to do for LSB first
+template <bool Msb>
+BERT_SSE static inline __m128i wireSse( __m128i v ) {
+    return Msb ? reverseSse( v ) : v;
+}
+
+template <bool Msb, class L>
+BERT_SSE static void fillSse( unsigned char *out, size_t words, uint64_t *reg, const L &lfsr ) {
+    uint64_t start[2], tail;
+    size_t seg = bertLanes( *reg, words, 2, 2, start, lfsr.order, lfsr.tap ), i;
+    __m128i w, r0, r1, inv = _mm_set1_epi64x( (long long) lfsr.invert );
+
+    if ( seg == 0 ) {
+        fillScalar<Msb>( out, words, reg, lfsr );
+        return;
+    }
+
+    w = _mm_set_epi64x( (long long) start[1], (long long) start[0] );
+    for ( i = 0; i < seg; i += 2 ) {
+        r0 = w;
+        r1 = nextSse( r0, lfsr );
+        w = nextSse( r1, lfsr );
+        _mm_storeu_si128( (__m128i *) (out + 8 * i), _mm_xor_si128( wireSse<Msb>( _mm_unpacklo_epi64( r0, r1 ) ), inv ) );
+        _mm_storeu_si128( (__m128i *) (out + 8 * (seg + i)), _mm_xor_si128( wireSse<Msb>( _mm_unpackhi_epi64( r0, r1 ) ), inv ) );
+    }
+
+    // the last lane ends where the leftover words start
+    tail = (uint64_t) _mm_extract_epi64( w, 1 );
+    fillScalar<Msb>( out + 8 * 2 * seg, words - 2 * seg, &tail, lfsr );
+    *reg = tail;
+}
+
+template <bool Msb, class L>
+BERT_SSE static uint64_t checkSse( const unsigned char *in, size_t words, uint64_t *reg, const L &lfsr ) {
+    uint64_t start[2], tail, errors = 0;
+    size_t seg = bertLanes( *reg, words, 2, 2, start, lfsr.order, lfsr.tap ), i;
+    __m128i w, r0, r1, d0, d1, inv = _mm_set1_epi64x( (long long) lfsr.invert );
+
+    if ( seg == 0 ) {
+        return checkScalar<Msb>( in, words, reg, lfsr );
+    }
+
+    w = _mm_set_epi64x( (long long) start[1], (long long) start[0] );
+    for ( i = 0; i < seg; i += 2 ) {
+        r0 = w;
+        r1 = nextSse( r0, lfsr );
+        w = nextSse( r1, lfsr );
+        d0 = _mm_xor_si128( _mm_xor_si128( wireSse<Msb>( _mm_unpacklo_epi64( r0, r1 ) ), inv ),
+                            _mm_loadu_si128( (const __m128i *) (in + 8 * i) ) );
+        d1 = _mm_xor_si128( _mm_xor_si128( wireSse<Msb>( _mm_unpackhi_epi64( r0, r1 ) ), inv ),
+                            _mm_loadu_si128( (const __m128i *) (in + 8 * (seg + i)) ) );
+        errors += _mm_popcnt_u64( (uint64_t) _mm_cvtsi128_si64( d0 ) ) + _mm_popcnt_u64( (uint64_t) _mm_extract_epi64( d0, 1 ) );
+        errors += _mm_popcnt_u64( (uint64_t) _mm_cvtsi128_si64( d1 ) ) + _mm_popcnt_u64( (uint64_t) _mm_extract_epi64( d1, 1 ) );
+    }
+
+    tail = (uint64_t) _mm_extract_epi64( w, 1 );
+    errors += checkScalar<Msb>( in + 8 * 2 * seg, words - 2 * seg, &tail, lfsr );
+    *reg = tail;
+    return errors;
+}
+
+BERT_SSE static uint64_t diffSse( const unsigned char *a, const unsigned char *b, size_t bytes ) {
+    uint64_t errors = 0;
+    size_t i;
+    for ( i = 0; i + 8 <= bytes; i += 8 ) {
+        errors += _mm_popcnt_u64( bertLoad64( a + i ) ^ bertLoad64( b + i ) );
+    }
+    return errors + diffScalar( a + i, b + i, bytes - i );
+}
+
+BERT_SSE static void reverseBufSse( unsigned char *out, const unsigned char *in, size_t bytes ) {
+    size_t i;
+    for ( i = 0; i + 16 <= bytes; i += 16 ) {
+        _mm_storeu_si128( (__m128i *) (out + i), reverseSse( _mm_loadu_si128( (const __m128i *) (in + i) ) ) );
+    }
+    reverseScalar( out + i, in + i, bytes - i );
+}
+
+////// AVX2, 4 lanes
+
+#define BERT_AVX2 __attribute__((target("avx2,popcnt")))
+
+template <class L>
+BERT_AVX2 static inline __m256i nextAvx2( __m256i w, const L &lfsr ) {
+    __m256i a = _mm256_xor_si256( _mm256_srli_epi64( w, 64 - lfsr.order ), _mm256_srli_epi64( w, 64 - lfsr.tap ) );
+    unsigned int t, o;
+    for ( t = lfsr.tap, o = lfsr.order; t < 64; t <<= 1, o <<= 1 ) {
+        a = _mm256_xor_si256( a, _mm256_xor_si256( _mm256_slli_epi64( a, t ), _mm256_slli_epi64( a, o ) ) );
+    }
+    return a;
+}
+
+BERT_AVX2 static inline __m256i reverseAvx2( __m256i v ) {
+    const __m256i lo = _mm256_setr_epi8( 0x00, (char) 0x80, 0x40, (char) 0xC0, 0x20, (char) 0xA0, 0x60, (char) 0xE0,
+                                         0x10, (char) 0x90, 0x50, (char) 0xD0, 0x30, (char) 0xB0, 0x70, (char) 0xF0,
+                                         0x00, (char) 0x80, 0x40, (char) 0xC0, 0x20, (char) 0xA0, 0x60, (char) 0xE0,
+                                         0x10, (char) 0x90, 0x50, (char) 0xD0, 0x30, (char) 0xB0, 0x70, (char) 0xF0 );
+    const __m256i hi = _mm256_setr_epi8( 0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF,
+                                         0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF );
+    const __m256i mask = _mm256_set1_epi8( 0x0F );
+    return _mm256_or_si256( _mm256_shuffle_epi8( lo, _mm256_and_si256( v, mask ) ),
+                            _mm256_shuffle_epi8( hi, _mm256_and_si256( _mm256_srli_epi16( v, 4 ), mask ) ) );
+}
+
+template <bool Msb>
+BERT_AVX2 static inline __m256i wireAvx2( __m256i v ) {
+    return Msb ? reverseAvx2( v ) : v;
+}
+
+// per 64 bit lane bit counts, nibble lookup then a byte sum
+BERT_AVX2 static inline __m256i popcountAvx2( __m256i v ) {
+    const __m256i lookup = _mm256_setr_epi8( 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                             0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 );
+    const __m256i mask = _mm256_set1_epi8( 0x0F );
+    __m256i cnt = _mm256_add_epi8( _mm256_shuffle_epi8( lookup, _mm256_and_si256( v, mask ) ),
+                                   _mm256_shuffle_epi8( lookup, _mm256_and_si256( _mm256_srli_epi16( v, 4 ), mask ) ) );
+    return _mm256_sad_epu8( cnt, _mm256_setzero_si256() );
+}
+
+// generate the next 4 words of every lane, returned in buffer order (c[l]
+// holds 4 consecutive words of lane l)
+template <bool Msb, class L>
+BERT_AVX2 static inline void generateAvx2( __m256i *w, __m256i *c, const L &lfsr ) {
+    __m256i r0, r1, r2, r3, t0, t1, t2, t3;
+    unsigned int k;
+    r0 = *w;
+    r1 = nextAvx2( r0, lfsr );
+    r2 = nextAvx2( r1, lfsr );
+    r3 = nextAvx2( r2, lfsr );
+    *w = nextAvx2( r3, lfsr );
+
+    t0 = _mm256_unpacklo_epi64( r0, r1 );
+    t1 = _mm256_unpackhi_epi64( r0, r1 );
+    t2 = _mm256_unpacklo_epi64( r2, r3 );
+    t3 = _mm256_unpackhi_epi64( r2, r3 );
+    c[0] = wireAvx2<Msb>( _mm256_permute2x128_si256( t0, t2, 0x20 ) );
+    c[1] = wireAvx2<Msb>( _mm256_permute2x128_si256( t1, t3, 0x20 ) );
+    c[2] = wireAvx2<Msb>( _mm256_permute2x128_si256( t0, t2, 0x31 ) );
+    c[3] = wireAvx2<Msb>( _mm256_permute2x128_si256( t1, t3, 0x31 ) );
+    if ( lfsr.invert ) {
+        const __m256i inv = _mm256_set1_epi64x( (long long) lfsr.invert );
+        for ( k = 0; k < 4; k++ ) {
+            c[k] = _mm256_xor_si256( c[k], inv );
+        }
+    }
+}
+
+template <bool Msb, class L>
+BERT_AVX2 static void fillAvx2( unsigned char *out, size_t words, uint64_t *reg, const L &lfsr ) {
+    uint64_t start[4], tail;
+    size_t seg = bertLanes( *reg, words, 4, 4, start, lfsr.order, lfsr.tap ), i;
+    unsigned int l;
+    __m256i w, c[4];
+
+    if ( seg == 0 ) {
+        fillScalar<Msb>( out, words, reg, lfsr );
+        return;
+    }
+
+    w = _mm256_loadu_si256( (const __m256i *) start );
+    for ( i = 0; i < seg; i += 4 ) {
+        generateAvx2<Msb>( &w, c, lfsr );
+        for ( l = 0; l < 4; l++ ) {
+            _mm256_storeu_si256( (__m256i *) (out + 8 * (l * seg + i)), c[l] );
+        }
+    }
+
+    tail = (uint64_t) _mm256_extract_epi64( w, 3 );
+    fillScalar<Msb>( out + 8 * 4 * seg, words - 4 * seg, &tail, lfsr );
+    *reg = tail;
+}
+
+template <bool Msb, class L>
+BERT_AVX2 static uint64_t checkAvx2( const unsigned char *in, size_t words, uint64_t *reg, const L &lfsr ) {
+    uint64_t start[4], tail, errors, sums[4];
+    size_t seg = bertLanes( *reg, words, 4, 4, start, lfsr.order, lfsr.tap ), i;
+    unsigned int l;
+    __m256i w, c[4], acc = _mm256_setzero_si256();
+
+    if ( seg == 0 ) {
+        return checkScalar<Msb>( in, words, reg, lfsr );
+    }
+
+    w = _mm256_loadu_si256( (const __m256i *) start );
+    for ( i = 0; i < seg; i += 4 ) {
+        generateAvx2<Msb>( &w, c, lfsr );
+        for ( l = 0; l < 4; l++ ) {
+            __m256i d = _mm256_loadu_si256( (const __m256i *) (in + 8 * (l * seg + i)) );
+            acc = _mm256_add_epi64( acc, popcountAvx2( _mm256_xor_si256( d, c[l] ) ) );
+        }
+    }
+    _mm256_storeu_si256( (__m256i *) sums, acc );
+    errors = sums[0] + sums[1] + sums[2] + sums[3];
+
+    tail = (uint64_t) _mm256_extract_epi64( w, 3 );
+    errors += checkScalar<Msb>( in + 8 * 4 * seg, words - 4 * seg, &tail, lfsr );
+    *reg = tail;
+    return errors;
+}
+
+BERT_AVX2 static uint64_t diffAvx2( const unsigned char *a, const unsigned char *b, size_t bytes ) {
+    uint64_t sums[4];
+    size_t i;
+    __m256i acc = _mm256_setzero_si256();
+    for ( i = 0; i + 32 <= bytes; i += 32 ) {
+        __m256i d = _mm256_xor_si256( _mm256_loadu_si256( (const __m256i *) (a + i) ),
+                                      _mm256_loadu_si256( (const __m256i *) (b + i) ) );
+        acc = _mm256_add_epi64( acc, popcountAvx2( d ) );
+    }
+    _mm256_storeu_si256( (__m256i *) sums, acc );
+    return sums[0] + sums[1] + sums[2] + sums[3] + diffSse( a + i, b + i, bytes - i );
+}
+
+BERT_AVX2 static void reverseBufAvx2( unsigned char *out, const unsigned char *in, size_t bytes ) {
+    size_t i;
+    for ( i = 0; i + 32 <= bytes; i += 32 ) {
+        _mm256_storeu_si256( (__m256i *) (out + i), reverseAvx2( _mm256_loadu_si256( (const __m256i *) (in + i) ) ) );
+    }
+    reverseBufSse( out + i, in + i, bytes - i );
+}
+
+////// AVX-512, 8 lanes
+
+// older GCC headers trip -Wuninitialized on _mm512_undefined_*() when the
+// intrinsics are inlined into target("avx512f") functions
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+#define BERT_AVX512 __attribute__((target("avx512f,avx512bw,avx512vpopcntdq,popcnt")))
+
+template <class L>
+BERT_AVX512 static inline __m512i nextAvx512( __m512i w, const L &lfsr ) {
+    __m512i a = _mm512_xor_si512( _mm512_srli_epi64( w, 64 - lfsr.order ), _mm512_srli_epi64( w, 64 - lfsr.tap ) );
+    unsigned int t, o;
+    for ( t = lfsr.tap, o = lfsr.order; t < 64; t <<= 1, o <<= 1 ) {
+        a = _mm512_xor_si512( a, _mm512_xor_si512( _mm512_slli_epi64( a, t ), _mm512_slli_epi64( a, o ) ) );
+    }
+    return a;
+}
+
+BERT_AVX512 static inline __m512i reverseAvx512( __m512i v ) {
+    const __m512i lo = _mm512_broadcast_i32x4( _mm_setr_epi8( 0x00, (char) 0x80, 0x40, (char) 0xC0, 0x20, (char) 0xA0, 0x60, (char) 0xE0,
+                                                              0x10, (char) 0x90, 0x50, (char) 0xD0, 0x30, (char) 0xB0, 0x70, (char) 0xF0 ) );
+    const __m512i hi = _mm512_broadcast_i32x4( _mm_setr_epi8( 0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF ) );
+    const __m512i mask = _mm512_set1_epi8( 0x0F );
+    return _mm512_or_si512( _mm512_shuffle_epi8( lo, _mm512_and_si512( v, mask ) ),
+                            _mm512_shuffle_epi8( hi, _mm512_and_si512( _mm512_srli_epi16( v, 4 ), mask ) ) );
+}
+
+template <bool Msb>
+BERT_AVX512 static inline __m512i wireAvx512( __m512i v ) {
+    return Msb ? reverseAvx512( v ) : v;
+}
+
+// generate the next 8 words of every lane, returned in buffer order via an
+// 8x8 transpose of 64 bit elements
+template <bool Msb, class L>
+BERT_AVX512 static inline void generateAvx512( __m512i *w, __m512i *c, const L &lfsr ) {
+    __m512i r[8], t[8], u[8];
+    unsigned int k;
+    r[0] = *w;
+    for ( k = 1; k < 8; k++ ) {
+        r[k] = nextAvx512( r[k-1], lfsr );
+    }
+    *w = nextAvx512( r[7], lfsr );
+
+    for ( k = 0; k < 8; k += 2 ) {
+        t[k]   = _mm512_unpacklo_epi64( r[k], r[k+1] );
+        t[k+1] = _mm512_unpackhi_epi64( r[k], r[k+1] );
+    }
+    for ( k = 0; k < 8; k += 4 ) {
+        u[k]   = _mm512_shuffle_i64x2( t[k],   t[k+2], _MM_SHUFFLE(2, 0, 2, 0) );
+        u[k+1] = _mm512_shuffle_i64x2( t[k],   t[k+2], _MM_SHUFFLE(3, 1, 3, 1) );
+        u[k+2] = _mm512_shuffle_i64x2( t[k+1], t[k+3], _MM_SHUFFLE(2, 0, 2, 0) );
+        u[k+3] = _mm512_shuffle_i64x2( t[k+1], t[k+3], _MM_SHUFFLE(3, 1, 3, 1) );
+    }
+    c[0] = wireAvx512<Msb>( _mm512_shuffle_i64x2( u[0], u[4], _MM_SHUFFLE(2, 0, 2, 0) ) );
+    c[4] = wireAvx512<Msb>( _mm512_shuffle_i64x2( u[0], u[4], _MM_SHUFFLE(3, 1, 3, 1) ) );
+    c[2] = wireAvx512<Msb>( _mm512_shuffle_i64x2( u[1], u[5], _MM_SHUFFLE(2, 0, 2, 0) ) );
+    c[6] = wireAvx512<Msb>( _mm512_shuffle_i64x2( u[1], u[5], _MM_SHUFFLE(3, 1, 3, 1) ) );
+    c[1] = wireAvx512<Msb>( _mm512_shuffle_i64x2( u[2], u[6], _MM_SHUFFLE(2, 0, 2, 0) ) );
+    c[5] = wireAvx512<Msb>( _mm512_shuffle_i64x2( u[2], u[6], _MM_SHUFFLE(3, 1, 3, 1) ) );
+    c[3] = wireAvx512<Msb>( _mm512_shuffle_i64x2( u[3], u[7], _MM_SHUFFLE(2, 0, 2, 0) ) );
+    c[7] = wireAvx512<Msb>( _mm512_shuffle_i64x2( u[3], u[7], _MM_SHUFFLE(3, 1, 3, 1) ) );
+    if ( lfsr.invert ) {
+        const __m512i inv = _mm512_set1_epi64( (long long) lfsr.invert );
+        for ( k = 0; k < 8; k++ ) {
+            c[k] = _mm512_xor_si512( c[k], inv );
+        }
+    }
+}
+
+template <bool Msb, class L>
+BERT_AVX512 static void fillAvx512( unsigned char *out, size_t words, uint64_t *reg, const L &lfsr ) {
+    uint64_t start[8], tail;
+    size_t seg = bertLanes( *reg, words, 8, 8, start, lfsr.order, lfsr.tap ), i;
+    unsigned int l;
+    __m512i w, c[8];
+
+    if ( seg == 0 ) {
+        fillAvx2<Msb>( out, words, reg, lfsr );
+        return;
+    }
+
+    w = _mm512_loadu_si512( start );
+    for ( i = 0; i < seg; i += 8 ) {
+        generateAvx512<Msb>( &w, c, lfsr );
+        for ( l = 0; l < 8; l++ ) {
+            _mm512_storeu_si512( out + 8 * (l * seg + i), c[l] );
+        }
+    }
+
+    tail = (uint64_t) _mm_extract_epi64( _mm512_extracti32x4_epi32( w, 3 ), 1 );
+    fillScalar<Msb>( out + 8 * 8 * seg, words - 8 * seg, &tail, lfsr );
+    *reg = tail;
+}
+
+template <bool Msb, class L>
+BERT_AVX512 static uint64_t checkAvx512( const unsigned char *in, size_t words, uint64_t *reg, const L &lfsr ) {
+    uint64_t start[8], tail, errors;
+    size_t seg = bertLanes( *reg, words, 8, 8, start, lfsr.order, lfsr.tap ), i;
+    unsigned int l;
+    __m512i w, c[8], acc = _mm512_setzero_si512();
+
+    if ( seg == 0 ) {
+        return checkAvx2<Msb>( in, words, reg, lfsr );
+    }
+
+    w = _mm512_loadu_si512( start );
+    for ( i = 0; i < seg; i += 8 ) {
+        generateAvx512<Msb>( &w, c, lfsr );
+        for ( l = 0; l < 8; l++ ) {
+            __m512i d = _mm512_loadu_si512( in + 8 * (l * seg + i) );
+            acc = _mm512_add_epi64( acc, _mm512_popcnt_epi64( _mm512_xor_si512( d, c[l] ) ) );
+        }
+    }
+    errors = (uint64_t) _mm512_reduce_add_epi64( acc );
+
+    tail = (uint64_t) _mm_extract_epi64( _mm512_extracti32x4_epi32( w, 3 ), 1 );
+    errors += checkScalar<Msb>( in + 8 * 8 * seg, words - 8 * seg, &tail, lfsr );
+    *reg = tail;
+    return errors;
+}
+
+BERT_AVX512 static uint64_t diffAvx512( const unsigned char *a, const unsigned char *b, size_t bytes ) {
+    size_t i;
+    __m512i acc = _mm512_setzero_si512();
+    for ( i = 0; i + 64 <= bytes; i += 64 ) {
+        __m512i d = _mm512_xor_si512( _mm512_loadu_si512( a + i ), _mm512_loadu_si512( b + i ) );
+        acc = _mm512_add_epi64( acc, _mm512_popcnt_epi64( d ) );
+    }
+    return (uint64_t) _mm512_reduce_add_epi64( acc ) + diffAvx2( a + i, b + i, bytes - i );
+}
+
+BERT_AVX512 static void reverseBufAvx512( unsigned char *out, const unsigned char *in, size_t bytes ) {
+    size_t i;
+    for ( i = 0; i + 64 <= bytes; i += 64 ) {
+        _mm512_storeu_si512( out + i, reverseAvx512( _mm512_loadu_si512( in + i ) ) );
+    }
+    reverseBufAvx2( out + i, in + i, bytes - i );
+}
+
+#pragma GCC diagnostic pop
+
+#endif // BERT_X86_KERNELS
+
+////// run time selection
+
+struct BertKernelSet {
+    const char *name;
+    uint64_t (*diff)( const unsigned char *, const unsigned char *, size_t );
+    void (*reverse)( unsigned char *, const unsigned char *, size_t );
+};
+
+// in order of preference, bertKernelLevel() is an index into this
+static const BertKernelSet bertKernelSets[] = {
+    { "scalar", diffScalar, reverseScalar },
+#ifdef BERT_X86_KERNELS
+    { "sse4.2", diffSse,    reverseBufSse    },
+    { "avx2",   diffAvx2,   reverseBufAvx2   },
+    { "avx512", diffAvx512, reverseBufAvx512 },
+#endif
+};
+
+static int bertSelectKernels() {
+    const char *cap = getenv( "BERT_KERNELS" );
+    int best = 0, n;
+
+#ifdef BERT_X86_KERNELS
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports( "sse4.2" ) && __builtin_cpu_supports( "popcnt" ) ) {
+        best = 1;
+        if ( __builtin_cpu_supports( "avx2" ) ) {
+            best = 2;
+            if ( __builtin_cpu_supports( "avx512f" ) && __builtin_cpu_supports( "avx512bw" )
+                 && __builtin_cpu_supports( "avx512vpopcntdq" ) ) {
+                best = 3;
+            }
+        }
+    }
+#endif
+
+    if ( cap != NULL ) {
+        for ( n = 0; n < best; n++ ) {
+            if ( strcmp( cap, bertKernelSets[n].name ) == 0 ) {
+                best = n;
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+static int bertKernelLevel() {
+    static const int level = bertSelectKernels();
+    return level;
+}
+
+// the kernel set for one LFSR and wire bit order
+template <bool Msb, class L>
+static void fillWords( unsigned char *out, size_t words, uint64_t *reg, const L &lfsr ) {
+    switch ( bertKernelLevel() ) {
+#ifdef BERT_X86_KERNELS
+        case 3:  fillAvx512<Msb>( out, words, reg, lfsr ); break;
+        case 2:  fillAvx2<Msb>( out, words, reg, lfsr );   break;
+        case 1:  fillSse<Msb>( out, words, reg, lfsr );    break;
+#endif
+        default: fillScalar<Msb>( out, words, reg, lfsr ); break;
+    }
+}
+
+template <bool Msb, class L>
+static uint64_t checkWords( const unsigned char *in, size_t words, uint64_t *reg, const L &lfsr ) {
+    switch ( bertKernelLevel() ) {
+#ifdef BERT_X86_KERNELS
+        case 3:  return checkAvx512<Msb>( in, words, reg, lfsr );
+        case 2:  return checkAvx2<Msb>( in, words, reg, lfsr );
+        case 1:  return checkSse<Msb>( in, words, reg, lfsr );
+#endif
+        default: return checkScalar<Msb>( in, words, reg, lfsr );
+    }
+}
+
+template <class L>
+static void fillWords( unsigned char *out, size_t words, uint64_t *reg, const L &lfsr, unsigned int bitOrder ) {
+    if ( bitOrder == BERT_MSB_FIRST ) {
+        fillWords<true>( out, words, reg, lfsr );
+    } else {
+        fillWords<false>( out, words, reg, lfsr );
+    }
+}
+
+template <class L>
+static uint64_t checkWords( const unsigned char *in, size_t words, uint64_t *reg, const L &lfsr, unsigned int bitOrder ) {
+    if ( bitOrder == BERT_MSB_FIRST ) {
+        return checkWords<true>( in, words, reg, lfsr );
+    }
+    return checkWords<false>( in, words, reg, lfsr );
+}
+
+// zero suppressed patterns, a word at a time through bertOutputWord()
+static void fillSuppressed( unsigned char *out, size_t words, uint64_t *reg, const BertPatternDesc *p,
+                            unsigned int bitOrder ) {
+    uint64_t w = *reg;
+    size_t i;
+    for ( i = 0; i < words; i++ ) {
+        bertStore64( out + 8 * i, bertWireWord( bertOutputWord( w, p ), bitOrder ) );
+        w = bertNextWord( w, p->order, p->tap );
+    }
+    *reg = w;
+}
+
+static uint64_t checkSuppressed( const unsigned char *in, size_t words, uint64_t *reg, const BertPatternDesc *p,
+                                 unsigned int bitOrder ) {
+    uint64_t w = *reg, errors = 0;
+    size_t i;
+    for ( i = 0; i < words; i++ ) {
+        errors += __builtin_popcountll( bertOutputWord( w, p ) ^ bertWireWord( bertLoad64( in + 8 * i ), bitOrder ) );
+        w = bertNextWord( w, p->order, p->tap );
+    }
+    *reg = w;
+    return errors;
+}
+
+// descriptor to the BertLfsr built for that pattern, once per call rather
+// than once per word
+void bertFillWords( unsigned char *out, size_t words, uint64_t *reg, const BertPatternDesc *p, unsigned int bitOrder ) {
+    if ( p->zeroSuppress ) {
+        fillSuppressed( out, words, reg, p, bitOrder );
+        return;
+    }
+#define BERT_FILL_CASE( pn, name, o, t, inv, zs ) \
+    if ( !(zs) && (p->order == (o)) && (p->tap == (t)) && ((p->invert != 0) == (inv)) ) { \
+        fillWords( out, words, reg, BertLfsr<(o), (t), (inv)>(), bitOrder ); \
+        return; \
+    }
+    BERT_PATTERNS( BERT_FILL_CASE )
+#undef BERT_FILL_CASE
+    fillWords( out, words, reg, BertLfsrRuntime( p->order, p->tap, p->invert ), bitOrder );
+}
+
+uint64_t bertCheckWords( const unsigned char *in, size_t words, uint64_t *reg, const BertPatternDesc *p,
+                         unsigned int bitOrder ) {
+    if ( p->zeroSuppress ) {
+        return checkSuppressed( in, words, reg, p, bitOrder );
+    }
+#define BERT_CHECK_CASE( pn, name, o, t, inv, zs ) \
+    if ( !(zs) && (p->order == (o)) && (p->tap == (t)) && ((p->invert != 0) == (inv)) ) { \
+        return checkWords( in, words, reg, BertLfsr<(o), (t), (inv)>(), bitOrder ); \
+    }
+    BERT_PATTERNS( BERT_CHECK_CASE )
+#undef BERT_CHECK_CASE
+    return checkWords( in, words, reg, BertLfsrRuntime( p->order, p->tap, p->invert ), bitOrder );
+}
+
+uint64_t bertDiffBits( const unsigned char *a, const unsigned char *b, size_t bytes ) {
+    return bertKernelSets[bertKernelLevel()].diff( a, b, bytes );
+}
+
+void bertReverseBits( unsigned char *out, const unsigned char *in, size_t bytes ) {
+    bertKernelSets[bertKernelLevel()].reverse( out, in, bytes );
+}
+
+const char *bertKernelName() {
+    return bertKernelSets[bertKernelLevel()].name;
+}
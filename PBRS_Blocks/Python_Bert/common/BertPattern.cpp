@@ -0,0 +1,238 @@
+/* BertPattern
+   Full period pattern tables shared by TxBert and RxBert.
+
+   Once a pattern has been generated for 8 periods the byte stream starts
+   over, so a table of 2^order-1 bytes replaces the LFSR with a cursor and
+   memcpy.  PN23 needs 8 MB, which is mapped on huge pages where the system
+   has them (explicit hugetlb pages first, then transparent huge pages) to
+   keep the TLB out of the way when the table is streamed.
+
+   The tables live for the life of the process.
+
+   A sparse index of register values, one every BERT_LOCATE_STRIDE bits,
+   lets a checker find where a register sits in the period by stepping it
+   at most that many bits.  The index holds the raw LFSR register, so it
+   works the same for inverted and zero suppressed patterns.
+
+   Tables are kept per PN, two patterns of the same order (PN20, PN20SZ)
+   send different bytes.
+
+   Patterns too long for a table are located with a baby-step giant-step
+   search instead: the registers of the first 2^(order/2) positions are
+   kept sorted and the register is jumped back that far at a time until it
+   lands on one of them, a few ms for PN31.
+*/
+
+#include "BertCommon.hpp"
+#include <stdlib.h>
+#include <algorithm>
+#include <pthread.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#define BERT_LOCATE_STRIDE 256
+#define BERT_HUGE_PAGE     (2UL * 1024 * 1024)
+
+struct BertPatternEntry {
+    unsigned int bytes;
+    unsigned char *table;   // MSB first
+    unsigned char *lsbTable;
+    uint64_t *index;        // (register << 32) | bit position, sorted
+    size_t indexSize;
+};
+
+static BertPatternEntry bertPatterns[BERT_PN_MAX + 1];
+
+// baby steps for bertPatternSolve(), register << 32 | bit position, sorted
+struct BertBabySteps {
+    uint64_t *steps;
+    uint64_t count;
+};
+
+static BertBabySteps bertBabySteps[BERT_PN_MAX + 1];
+static pthread_mutex_t bertPatternLock = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned char *bertAllocTable( size_t bytes ) {
+#ifdef __linux__
+    void *p;
+    size_t len = (bytes + BERT_HUGE_PAGE - 1) & ~(BERT_HUGE_PAGE - 1);
+    if ( bytes >= BERT_HUGE_PAGE ) {
+#ifdef MAP_HUGETLB
+        p = mmap( NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+        if ( p != MAP_FAILED ) {
+            return (unsigned char *) p;
+        }
+#endif
+        p = mmap( NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+        if ( p != MAP_FAILED ) {
+#ifdef MADV_HUGEPAGE
+            madvise( p, len, MADV_HUGEPAGE );
+#endif
+            return (unsigned char *) p;
+        }
+    }
+#endif
+    return (unsigned char *) malloc( bytes );
+}
+
+// build the table for a pattern, called with bertPatternLock held
+static void bertBuildTable( BertPatternEntry *e, const BertPatternDesc *p ) {
+    unsigned int bytes = (1U << p->order) - 1, words = bytes / 8;
+    uint64_t reg = bertSeedWord( 0xFFFFFFFF, p->order, p->tap );
+    unsigned char *table = bertAllocTable( bytes + 8 ), last[8];
+    if ( table == NULL ) {
+        return;
+    }
+
+    bertFillWords( table, words, &reg, p, BERT_MSB_FIRST );
+    bertFillWords( last, 1, &reg, p, BERT_MSB_FIRST );
+    memcpy( table + 8 * words, last, bytes - 8 * words );
+    memcpy( table + bytes, table, 8 );
+
+    e->bytes = bytes;
+    e->table = table;
+}
+
+// the index is built from the raw stream, BERT_LOCATE_STRIDE bits is a
+// whole number of words so the register is the low bits of every 4th word
+static void bertBuildIndex( BertPatternEntry *e, const BertPatternDesc *p ) {
+    uint64_t period = (1ULL << p->order) - 1, bit, w = bertSeedWord( 0xFFFFFFFF, p->order, p->tap );
+    unsigned int k;
+    size_t n = 0;
+    uint64_t *index = (uint64_t *) malloc( sizeof(uint64_t) * (period / BERT_LOCATE_STRIDE + 1) );
+    if ( index == NULL ) {
+        return;
+    }
+    for ( bit = 0; bit < period; bit += BERT_LOCATE_STRIDE ) {
+        index[n++] = ((w & period) << 32) | bit;
+        for ( k = 0; k < BERT_LOCATE_STRIDE / 64; k++ ) {
+            w = bertNextWord( w, p->order, p->tap );
+        }
+    }
+    std::sort( index, index + n );
+    e->index = index;
+    e->indexSize = n;
+}
+
+// the LSB first table is the MSB first one with every byte reversed
+static void bertBuildLsbTable( BertPatternEntry *e ) {
+    unsigned char *table = bertAllocTable( e->bytes + 8 );
+    if ( table == NULL ) {
+        return;
+    }
+    bertReverseBits( table, e->table, e->bytes + 8 );
+    e->lsbTable = table;
+}
+
+static BertPatternEntry *bertPattern( const BertPatternDesc *p, int withIndex, int withLsb ) {
+    BertPatternEntry *e;
+    if ( (p == NULL) || (p->order > BERT_TABLE_MAX_ORDER) || (p->PN < 0) || (p->PN > BERT_PN_MAX) ) {
+        return NULL;
+    }
+    e = &bertPatterns[p->PN];
+    pthread_mutex_lock( &bertPatternLock );
+    if ( e->table == NULL ) {
+        bertBuildTable( e, p );
+    }
+    if ( withIndex && (e->table != NULL) && (e->index == NULL) ) {
+        bertBuildIndex( e, p );
+    }
+    if ( withLsb && (e->table != NULL) && (e->lsbTable == NULL) ) {
+        bertBuildLsbTable( e );
+    }
+    pthread_mutex_unlock( &bertPatternLock );
+    if ( (e->table == NULL) || (withIndex && (e->index == NULL)) || (withLsb && (e->lsbTable == NULL)) ) {
+        return NULL;
+    }
+    return e;
+}
+
+const unsigned char *bertPatternTable( const BertPatternDesc *p, unsigned int bitOrder, unsigned int *bytes ) {
+    BertPatternEntry *e = bertPattern( p, 0, bitOrder == BERT_LSB_FIRST );
+    if ( e == NULL ) {
+        return NULL;
+    }
+    *bytes = e->bytes;
+    return (bitOrder == BERT_LSB_FIRST) ? e->lsbTable : e->table;
+}
+
+// one bit step, s[n+order] = s[n] ^ s[n+order-tap]
+static inline uint64_t bertStepRegister( uint64_t reg, unsigned int order, unsigned int tap ) {
+    return (reg >> 1) | (((reg ^ (reg >> (order - tap))) & 1) << (order - 1));
+}
+
+// baby-step giant-step, for patterns with no table to index
+static int64_t bertPatternSolve( const BertPatternDesc *p, uint64_t reg ) {
+    BertBabySteps *b;
+    uint64_t period, m, k, j, back, w, key, *hit, *steps;
+    unsigned int order, tap;
+
+    if ( (p == NULL) || (p->PN < 0) || (p->PN > BERT_PN_MAX) || (p->order > 32) ) {
+        return -1;
+    }
+    order = p->order;
+    tap = p->tap;
+    period = (1ULL << order) - 1;
+    m = 1ULL << ((order + 1) / 2);
+    reg &= period;
+    if ( reg == 0 ) {
+        return -1;
+    }
+
+    b = &bertBabySteps[p->PN];
+    pthread_mutex_lock( &bertPatternLock );
+    if ( b->steps == NULL ) {
+        steps = (uint64_t *) malloc( sizeof(uint64_t) * m );
+        if ( steps != NULL ) {
+            w = bertSeedWord( 0xFFFFFFFF, order, tap ) & period;
+            for ( k = 0; k < m; k++ ) {
+                steps[k] = (w << 32) | k;
+                w = bertStepRegister( w, order, tap );
+            }
+            std::sort( steps, steps + m );
+            b->steps = steps;
+            b->count = m;
+        }
+    }
+    pthread_mutex_unlock( &bertPatternLock );
+    if ( b->steps == NULL ) {
+        return -1;
+    }
+
+    // position j * m + k, stepping back m bits lands on baby step k
+    back = bertJumpPoly( period - m % period, order, tap );
+    w = bertSeedWord( reg, order, tap );
+    for ( j = 0; j * m < period + m; j++ ) {
+        key = (w & period) << 32;
+        hit = std::lower_bound( b->steps, b->steps + b->count, key );
+        if ( (hit != b->steps + b->count) && ((*hit >> 32) == (w & period)) ) {
+            return (int64_t) ((j * m + (*hit & 0xFFFFFFFF)) % period);
+        }
+        w = bertJumpWord( w, back, order, tap );
+    }
+    return -1;
+}
+
+int64_t bertPatternLocate( const BertPatternDesc *p, uint64_t reg ) {
+    BertPatternEntry *e = bertPattern( p, 1, 0 );
+    uint64_t period, key, *hit;
+    unsigned int k, order, tap;
+    if ( e == NULL ) {
+        return bertPatternSolve( p, reg );
+    }
+    order = p->order;
+    tap = p->tap;
+    period = (1ULL << order) - 1;
+
+    reg &= period;
+    for ( k = 0; (k < BERT_LOCATE_STRIDE) && (reg != 0); k++ ) {
+        key = reg << 32;
+        hit = std::lower_bound( e->index, e->index + e->indexSize, key );
+        if ( (hit != e->index + e->indexSize) && ((*hit >> 32) == reg) ) {
+            return (int64_t) (((*hit & 0xFFFFFFFF) + period - k) % period);
+        }
+        reg = bertStepRegister( reg, order, tap );
+    }
+    return -1;
+}
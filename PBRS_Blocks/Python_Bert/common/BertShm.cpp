@@ -0,0 +1,145 @@
+/* BertShm
+   Shared memory stats page for TxBert and RxBert.
+
+   The layout, BertShmPage in BertCommon.hpp, is the interface: a monitor
+   process in any language maps the segment and reads it under the
+   sequence count, nothing here has to be linked into it.  The attach and
+   read functions are the same thing for C++ monitors.
+
+   Only one thread writes a page, the one calling fill() or check() on the
+   object that owns it.
+*/
+
+#include "BertCommon.hpp"
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+BertShmPage *bertShmCreate( const char *name, unsigned int role, uint64_t sampleBits ) {
+    BertShmPage *page;
+    void *p;
+    int fd;
+
+    if ( (name == NULL) || (name[0] == 0) ) {
+        return NULL;
+    }
+    fd = shm_open( name, O_RDWR | O_CREAT, 0644 );
+    if ( fd < 0 ) {
+        return NULL;
+    }
+    if ( ftruncate( fd, sizeof(BertShmPage) ) != 0 ) {
+        close( fd );
+        return NULL;
+    }
+    p = mmap( NULL, sizeof(BertShmPage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    close( fd );
+    if ( p == MAP_FAILED ) {
+        return NULL;
+    }
+
+    // magic goes in last, a monitor that attaches part way through does not
+    // take the page for a good one
+    page = (BertShmPage *) p;
+    __atomic_store_n( &page->magic, 0, __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+    memset( (char *) page + sizeof(page->magic), 0, sizeof(BertShmPage) - sizeof(page->magic) );
+    page->version = BERT_SHM_VERSION;
+    page->size = sizeof(BertShmPage);
+    page->role = role;
+    page->PN = -1;
+    page->sampleBits = (sampleBits != 0) ? sampleBits : 1;
+    __atomic_store_n( &page->magic, BERT_SHM_MAGIC, __ATOMIC_RELEASE );
+    return page;
+}
+
+void bertShmDestroy( BertShmPage *page, const char *name ) {
+    if ( page == NULL ) {
+        return;
+    }
+    munmap( page, sizeof(BertShmPage) );
+    shm_unlink( name );
+}
+
+// seq odd, then the stores, the fence keeps them after it
+void bertShmBegin( BertShmPage *page ) {
+    __atomic_store_n( &page->seq, page->seq + 1, __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+}
+
+void bertShmEnd( BertShmPage *page ) {
+    __atomic_store_n( &page->seq, page->seq + 1, __ATOMIC_RELEASE );
+}
+
+void bertShmSample( BertShmPage *page ) {
+    BertShmSample *s;
+    struct timespec now;
+    uint64_t last = 0;
+
+    if ( page->samples != 0 ) {
+        last = page->history[(page->samples - 1) % BERT_SHM_HISTORY].bits;
+    }
+    if ( (page->bits < last + page->sampleBits) && (page->samples != 0) ) {
+        return;
+    }
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    s = &page->history[page->samples % BERT_SHM_HISTORY];
+    s->time = (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+    s->bits = page->bits;
+    s->bitsInSync = page->bitsInSync;
+    s->errors = page->errors;
+    page->samples++;
+}
+
+const BertShmPage *bertShmAttach( const char *name ) {
+    const BertShmPage *page;
+    struct stat st;
+    void *p;
+    int fd;
+
+    fd = shm_open( name, O_RDONLY, 0 );
+    if ( fd < 0 ) {
+        return NULL;
+    }
+    if ( (fstat( fd, &st ) != 0) || ((size_t) st.st_size < sizeof(BertShmPage)) ) {
+        close( fd );
+        return NULL;
+    }
+    p = mmap( NULL, sizeof(BertShmPage), PROT_READ, MAP_SHARED, fd, 0 );
+    close( fd );
+    if ( p == MAP_FAILED ) {
+        return NULL;
+    }
+    page = (const BertShmPage *) p;
+    if ( (__atomic_load_n( &page->magic, __ATOMIC_ACQUIRE ) != BERT_SHM_MAGIC) ||
+         (page->version != BERT_SHM_VERSION) || (page->size != sizeof(BertShmPage)) ) {
+        munmap( p, sizeof(BertShmPage) );
+        return NULL;
+    }
+    return page;
+}
+
+void bertShmDetach( const BertShmPage *page ) {
+    if ( page != NULL ) {
+        munmap( (void *) page, sizeof(BertShmPage) );
+    }
+}
+
+int bertShmRead( const BertShmPage *page, BertShmPage *out ) {
+    uint64_t seq;
+    unsigned int tries;
+
+    for ( tries = 0; tries < 1000; tries++ ) {
+        seq = __atomic_load_n( &page->seq, __ATOMIC_ACQUIRE );
+        if ( seq & 1 ) {
+            continue;
+        }
+        memcpy( out, page, offsetof( BertShmPage, history ) );
+        __atomic_thread_fence( __ATOMIC_ACQUIRE );
+        if ( __atomic_load_n( &page->seq, __ATOMIC_RELAXED ) == seq ) {
+            return 1;
+        }
+    }
+    return 0;
+}
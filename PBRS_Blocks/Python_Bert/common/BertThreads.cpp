@@ -0,0 +1,146 @@
+/* BertThreads
+   Persistent worker pool for splitting very large fill() and check() calls.
+
+   Workers are started the first time they are needed and then sleep on a
+   condition variable between jobs, so a call only pays for a wake up.  A
+   job is a count of chunks handed out through an atomic counter, and the
+   calling thread works on chunks too.  Only one job runs at a time.
+*/
+
+#include "BertCommon.hpp"
+#include <pthread.h>
+#include <unistd.h>
+
+#define BERT_MAX_THREADS 64
+
+struct BertJob {
+    void (*fn)( void *arg, unsigned int chunk );
+    void *arg;
+    unsigned int chunks;
+    unsigned int next;      // next chunk to hand out, atomic
+    unsigned int done;      // chunks finished
+    unsigned int joined;    // workers that took the job
+    unsigned int active;    // workers still holding a pointer to the job
+    unsigned int maxWorkers;
+};
+
+static pthread_mutex_t bertPoolLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t bertJobLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t bertPoolWake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t bertPoolDone = PTHREAD_COND_INITIALIZER;
+static BertJob *bertPoolJob = NULL;
+static unsigned long bertPoolGeneration = 0;
+static unsigned int bertPoolWorkers = 0;
+
+static void bertRunChunks( BertJob *job ) {
+    unsigned int chunk;
+    while ( (chunk = __sync_fetch_and_add( &job->next, 1 )) < job->chunks ) {
+        job->fn( job->arg, chunk );
+        pthread_mutex_lock( &bertPoolLock );
+        job->done++;
+        if ( job->done == job->chunks ) {
+            pthread_cond_broadcast( &bertPoolDone );
+        }
+        pthread_mutex_unlock( &bertPoolLock );
+    }
+}
+
+static void *bertWorker( void *unused ) {
+    unsigned long seen = 0;
+    BertJob *job;
+    (void) unused;
+
+    pthread_mutex_lock( &bertPoolLock );
+    for (;;) {
+        while ( bertPoolGeneration == seen ) {
+            pthread_cond_wait( &bertPoolWake, &bertPoolLock );
+        }
+        seen = bertPoolGeneration;
+        job = bertPoolJob;
+        if ( (job == NULL) || (job->joined >= job->maxWorkers) ) {
+            continue;
+        }
+        job->joined++;
+        job->active++;
+        pthread_mutex_unlock( &bertPoolLock );
+
+        bertRunChunks( job );
+
+        pthread_mutex_lock( &bertPoolLock );
+        job->active--;
+        if ( job->active == 0 ) {
+            pthread_cond_broadcast( &bertPoolDone );
+        }
+    }
+    return NULL;
+}
+
+// start workers until there are at least n, called with bertPoolLock held
+static void bertGrowPool( unsigned int n ) {
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init( &attr );
+    pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED );
+    while ( bertPoolWorkers < n ) {
+        if ( pthread_create( &thread, &attr, bertWorker, NULL ) != 0 ) {
+            break;
+        }
+        bertPoolWorkers++;
+    }
+    pthread_attr_destroy( &attr );
+}
+
+unsigned int bertThreadCount( unsigned int threads ) {
+    long cpus;
+    if ( threads == 0 ) {
+        cpus = sysconf( _SC_NPROCESSORS_ONLN );
+        threads = (cpus > 0) ? (unsigned int) cpus : 1;
+    }
+    return (threads > BERT_MAX_THREADS) ? BERT_MAX_THREADS : threads;
+}
+
+void bertParallel( unsigned int chunks, void (*fn)( void *arg, unsigned int chunk ), void *arg, unsigned int threads ) {
+    BertJob job;
+    unsigned int n;
+
+    threads = bertThreadCount( threads );
+    if ( (threads <= 1) || (chunks <= 1) ) {
+        for ( n = 0; n < chunks; n++ ) {
+            fn( arg, n );
+        }
+        return;
+    }
+
+    job.fn = fn;
+    job.arg = arg;
+    job.chunks = chunks;
+    job.next = 0;
+    job.done = 0;
+    job.joined = 0;
+    job.active = 0;
+    job.maxWorkers = threads - 1;
+
+    pthread_mutex_lock( &bertJobLock );
+
+    pthread_mutex_lock( &bertPoolLock );
+    bertGrowPool( threads - 1 );
+    bertPoolJob = &job;
+    bertPoolGeneration++;
+    pthread_cond_broadcast( &bertPoolWake );
+    pthread_mutex_unlock( &bertPoolLock );
+
+    bertRunChunks( &job );
+
+    // wait for the last chunk and for every worker to let go of the job
+    pthread_mutex_lock( &bertPoolLock );
+    while ( job.done < job.chunks ) {
+        pthread_cond_wait( &bertPoolDone, &bertPoolLock );
+    }
+    bertPoolJob = NULL;
+    while ( job.active != 0 ) {
+        pthread_cond_wait( &bertPoolDone, &bertPoolLock );
+    }
+    pthread_mutex_unlock( &bertPoolLock );
+
+    pthread_mutex_unlock( &bertJobLock );
+}
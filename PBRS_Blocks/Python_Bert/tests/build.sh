@@ -0,0 +1,13 @@
+#!/bin/bash
+# build and run the checker tests against the module sources
+CXX=${CXX:-g++}
+SRC="../TxBert/TxBert.cpp ../RxBert/RxBert.cpp ../common/BertKernels.cpp ../common/BertPattern.cpp ../common/BertThreads.cpp ../common/BertShm.cpp"
+
+for t in burstTest setPnTest syncLossTest; do
+    $CXX -O2 -I../common -I../TxBert -I../RxBert $t.cpp $SRC -o $t -lpthread -lrt || exit 1
+    ./$t || exit 1
+done
+
+# the generator without any period tables
+$CXX -O2 -DBERT_TABLE_MAX_ORDER=0 -I../common -I../TxBert -I../RxBert setPnTest.cpp $SRC -o setPnTest -lpthread -lrt || exit 1
+./setPnTest || exit 1
@@ -0,0 +1,129 @@
+/* burstTest
+   Error log burst accounting.  The same pair of errors, placed at every
+   bit alignment against the 64 bit words of the checker, has to give the
+   same bursts, a burst still running is not counted by reading the
+   counts, and syncloss part way through a word must not log an empty
+   error mask.
+*/
+
+#include "TxBert.hpp"
+#include "RxBert.hpp"
+#include <stdio.h>
+#include <vector>
+
+// flip stream bit of an MSB first buffer
+static void flipBit( std::vector<unsigned char> &data, uint64_t bit ) {
+    data[bit / 8] ^= 0x80 >> (bit % 8);
+}
+
+static int checkPair( unsigned int align, unsigned int burstGap, unsigned int byteWise,
+                      unsigned long bursts, unsigned long bin ) {
+    TxBert tx( BERT_PN11 );
+    RxBert rx( BERT_PN11 );
+    std::vector<unsigned char> data( 4096 );
+    unsigned int n;
+
+    tx.fill( &data[0], data.size() );
+    flipBit( data, 8000 + align );
+    flipBit( data, 8020 + align );
+    rx.setErrorLog( 64, burstGap );
+    if ( byteWise ) {
+        for ( n = 0; n < data.size(); n++ ) {
+            rx.check( &data[n], 1 );
+        }
+    } else {
+        rx.check( &data[0], data.size() );
+    }
+    if ( (rx.getErrors() != 2) || (rx.getBurstCount() != bursts) || (rx.getBurstHistogram( bin ) != bursts) ) {
+        printf( "align %u gap %u byteWise %u: errors %lu bursts %lu, want %lu in bin %lu\n", align, burstGap,
+                byteWise, rx.getErrors(), rx.getBurstCount(), bursts, bin );
+        return 1;
+    }
+    return 0;
+}
+
+// a burst running at the end of a check() call is not counted, however
+// often the counts are read, until the data after it or a gap ends it
+static int checkOpen( unsigned int gapBits ) {
+    TxBert tx( BERT_PN11 );
+    RxBert rx( BERT_PN11 );
+    std::vector<unsigned char> data( 4096 );
+
+    tx.fill( &data[0], data.size() );
+    flipBit( data, 8 * 2048 - 2 );
+    rx.setErrorLog( 64, 16 );
+    rx.check( &data[0], 2048 );
+    if ( (rx.getBurstCount() != 0) || (rx.getBurstCount() != 0) || (rx.getBurstHistogram( 0 ) != 0) ) {
+        printf( "open burst counted after %lu bits\n", rx.getBitsRX() );
+        return 1;
+    }
+    if ( gapBits != 0 ) {
+        rx.advance( gapBits );
+    } else {
+        rx.check( &data[2048], 8 );
+    }
+    if ( (rx.getBurstCount() != 1) || (rx.getBurstHistogram( 0 ) != 1) ) {
+        printf( "gap %u: %lu bursts after the burst ended\n", gapBits, rx.getBurstCount() );
+        return 1;
+    }
+    return 0;
+}
+
+// bytes hit at random in stretches of the stream drive the checker in and
+// out of sync, in buffers of odd sizes so the syncloss window is not lined
+// up with the words.  Every event logged has to have an error in it.
+static int checkEvents() {
+    TxBert tx( BERT_PN11 );
+    RxBert rx( BERT_PN11 );
+    std::vector<unsigned char> data( 1 << 22 );
+    BertErrorEvent e;
+    unsigned int n, k, bad = 0;
+    uint64_t seed = 1;
+
+    tx.fill( &data[0], data.size() );
+    for ( n = 0; n < data.size(); n++ ) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        if ( (((n >> 11) & 7) == 5) && (seed >> 63) ) {
+            data[n] ^= (unsigned char) (seed >> 40) | 1;
+        }
+    }
+    rx.setErrorLog( 1 << 16, 8 );
+    for ( n = 0; n < data.size(); n += k ) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        k = 1 + (unsigned int) (seed >> 33) % 999;
+        if ( k > data.size() - n ) {
+            k = data.size() - n;
+        }
+        rx.check( &data[n], k );
+        while ( rx.readErrorEvent( &e ) ) {
+            if ( (e.mask == 0) || (e.run > 8 * data.size()) ) {
+                bad++;
+            }
+        }
+    }
+    if ( bad || (rx.getSyncLossCount() == 0) ) {
+        printf( "events: %u bad, %lu synclosses\n", bad, rx.getSyncLossCount() );
+        return 1;
+    }
+    return 0;
+}
+
+int main() {
+    unsigned int align, byteWise, failed = 0;
+
+    for ( align = 0; align < 128; align++ ) {
+        for ( byteWise = 0; byteWise < 2; byteWise++ ) {
+            // 20 bits apart, two bursts of one bit with a gap of 4 or 20,
+            // one of 21 bits with a gap of 21 or 32
+            failed += checkPair( align, 4, byteWise, 2, 0 );
+            failed += checkPair( align, 20, byteWise, 2, 0 );
+            failed += checkPair( align, 21, byteWise, 1, 4 );
+            failed += checkPair( align, 32, byteWise, 1, 4 );
+        }
+    }
+    failed += checkOpen( 0 );
+    failed += checkOpen( 16 );
+    failed += checkEvents();
+    printf( "burstTest: %s\n", failed ? "FAILED" : "passed" );
+    return failed ? 1 : 0;
+}
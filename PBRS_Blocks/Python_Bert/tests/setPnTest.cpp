@@ -0,0 +1,48 @@
+/* setPnTest
+   TxBert::setPN() part way through a stream.  Whatever the old pattern
+   left in the generator, the data after the switch has to be the new
+   pattern, with or without a period table either side of it.  Built a
+   second time with BERT_TABLE_MAX_ORDER=0 for the no table case.
+*/
+
+#include "TxBert.hpp"
+#include "RxBert.hpp"
+#include <stdio.h>
+#include <vector>
+
+// from pattern a to b after head bytes, in both bit orders
+static int checkSwitch( int a, int b, unsigned int head ) {
+    std::vector<unsigned char> data( 1 << 16 );
+    unsigned int bitOrder, failed = 0;
+
+    for ( bitOrder = BERT_MSB_FIRST; bitOrder <= BERT_LSB_FIRST; bitOrder++ ) {
+        TxBert tx( a );
+        RxBert rx( b );
+        tx.setBitOrder( bitOrder );
+        rx.setBitOrder( bitOrder );
+        tx.fill( &data[0], head );
+        tx.setPN( b );
+        tx.fill( &data[0], data.size() );
+        rx.check( &data[0], data.size() );
+        if ( !rx.synced() || (rx.getErrors() != 0) || (rx.getSyncLossCount() != 0) ) {
+            printf( "PN %d to %d after %u bytes, bit order %u: synced %u, %lu errors, %lu synclosses\n", a, b, head,
+                    bitOrder, rx.synced(), rx.getErrors(), rx.getSyncLossCount() );
+            failed++;
+        }
+    }
+    return failed;
+}
+
+int main() {
+    static const int pairs[][2] = { { BERT_PN7, BERT_PN31 }, { BERT_PN11, BERT_PN23 }, { BERT_PN23, BERT_PN31 },
+                                    { BERT_PN31, BERT_PN7 }, { BERT_PN31, BERT_PN20SZ }, { BERT_PN20SZ, BERT_PN9 } };
+    unsigned int n, failed = 0;
+
+    for ( n = 0; n < sizeof(pairs) / sizeof(pairs[0]); n++ ) {
+        // on a word boundary and part way through a word
+        failed += checkSwitch( pairs[n][0], pairs[n][1], 1000 );
+        failed += checkSwitch( pairs[n][0], pairs[n][1], 1003 );
+    }
+    printf( "setPnTest: %s\n", failed ? "FAILED" : "passed" );
+    return failed ? 1 : 0;
+}
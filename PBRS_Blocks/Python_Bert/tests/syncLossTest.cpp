@@ -0,0 +1,152 @@
+/* syncLossTest
+   Sliding syncloss window.  A burst over the threshold has to drop sync
+   wherever it falls against the 64 bit words of the checker, whether the
+   data comes a byte at a time, in one buffer, or in buffers big enough for
+   the worker pool.  Random errors at rates either side of the threshold
+   give the same counts in one buffer as a byte at a time, with and
+   without a period table.  A slip found by the slip detector is placed
+   within a word of where it happened, even right after the first lock.
+*/
+
+#include "TxBert.hpp"
+#include "RxBert.hpp"
+#include <stdio.h>
+#include <vector>
+
+// flip stream bit of an MSB first buffer
+static void flipBit( std::vector<unsigned char> &data, uint64_t bit ) {
+    data[bit / 8] ^= 0x80 >> (bit % 8);
+}
+
+// 50 errors within 100 bits, every other bit from start, against the
+// default window of 28 errors in 128 bits
+static int checkBurst( int PN, uint64_t start, unsigned int phase, unsigned int feed, std::vector<unsigned char> &data ) {
+    static const char *feeds[] = { "one buffer", "byte wise", "threaded" };
+    RxBert rx( PN );
+    unsigned int n;
+
+    for ( n = 0; n < 100; n += 2 ) {
+        flipBit( data, start + phase + n );
+    }
+    if ( feed == 1 ) {
+        for ( n = 0; n < data.size(); n++ ) {
+            rx.check( &data[n], 1 );
+        }
+    } else {
+        rx.setThreads( (feed == 2) ? 4 : 1 );
+        rx.check( &data[0], data.size() );
+    }
+    for ( n = 0; n < 100; n += 2 ) {
+        flipBit( data, start + phase + n );
+    }
+    if ( (rx.getSyncLossCount() != 1) || !rx.synced() ) {
+        printf( "PN %d phase %u %s: %lu synclosses, synced %u\n", PN, phase, feeds[feed], rx.getSyncLossCount(),
+                rx.synced() );
+        return 1;
+    }
+    return 0;
+}
+
+// the same 28 errors spread over two windows' worth of bits stay in sync
+static int checkSpread( unsigned int phase ) {
+    TxBert tx( BERT_PN11 );
+    RxBert rx( BERT_PN11 );
+    std::vector<unsigned char> data( 4096 );
+    unsigned int n;
+
+    tx.fill( &data[0], data.size() );
+    for ( n = 0; n < 29; n++ ) {
+        flipBit( data, 8000 + phase + 9 * n );
+    }
+    rx.check( &data[0], data.size() );
+    if ( rx.getSyncLossCount() != 0 ) {
+        printf( "phase %u spread: %lu synclosses\n", phase, rx.getSyncLossCount() );
+        return 1;
+    }
+    return 0;
+}
+
+// stretches of 64 KB at error rates of 1e-4, 1e-3, 1e-2 and 0.3, the last
+// well over the threshold, checked in one buffer and a byte at a time
+static int checkRates( int PN ) {
+    static const double rates[] = { 1e-4, 1e-3, 1e-2, 0.3 };
+    TxBert tx( PN );
+    RxBert bulk( PN ), byteWise( PN );
+    std::vector<unsigned char> data( 1 << 20 );
+    uint64_t bit, seed = 1;
+    unsigned int n;
+
+    tx.fill( &data[0], data.size() );
+    for ( bit = 0; bit < 8 * data.size(); bit++ ) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        if ( (double) (seed >> 11) < rates[(bit >> 19) & 3] * 9007199254740992.0 ) {
+            flipBit( data, bit );
+        }
+    }
+    bulk.setThreads( 1 );
+    bulk.check( &data[0], data.size() );
+    for ( n = 0; n < data.size(); n++ ) {
+        byteWise.check( &data[n], 1 );
+    }
+    if ( (bulk.getErrors() != byteWise.getErrors()) || (bulk.getSyncLossCount() != byteWise.getSyncLossCount()) ||
+         (bulk.getBitsRXinSync() != byteWise.getBitsRXinSync()) || (bulk.getSyncLossCount() == 0) ) {
+        printf( "PN %d rates: %lu errors %lu synclosses in bulk, %lu and %lu byte wise\n", PN, bulk.getErrors(),
+                bulk.getSyncLossCount(), byteWise.getErrors(), byteWise.getSyncLossCount() );
+        return 1;
+    }
+    return 0;
+}
+
+// 5 bits deleted at bit slip of the stream
+static int checkSlip( unsigned int slip ) {
+    TxBert tx( BERT_PN11 );
+    RxBert rx( BERT_PN11 );
+    std::vector<unsigned char> data( 4096 ), cut( 4096 );
+    uint64_t n, m;
+
+    tx.fill( &data[0], data.size() );
+    for ( n = 0, m = 0; m < 8 * cut.size(); n++ ) {
+        if ( (n >= slip) && (n < slip + 5) ) {
+            continue;
+        }
+        if ( data[n / 8] & (0x80 >> (n % 8)) ) {
+            cut[m / 8] |= 0x80 >> (m % 8);
+        }
+        m++;
+    }
+    rx.setSlipDetect( 8 );
+    rx.check( &cut[0], cut.size() - 8 );
+    if ( (rx.getDeletions() != 1) || (rx.getLastSlipPosition() >= slip + 64) ||
+         (rx.getLastSlipPosition() + 64 <= slip) ) {
+        printf( "slip at %u: %lu deletions at %lu\n", slip, rx.getDeletions(), rx.getLastSlipPosition() );
+        return 1;
+    }
+    return 0;
+}
+
+int main() {
+    TxBert tx( BERT_PN11 ), wideTx( BERT_PN31 );
+    std::vector<unsigned char> small( 4096 ), large( 6 << 20 ), wide( 1 << 16 );
+    unsigned int phase, failed = 0;
+
+    tx.fill( &small[0], small.size() );
+    tx.resetState();
+    tx.fill( &large[0], large.size() );
+    wideTx.fill( &wide[0], wide.size() );
+    for ( phase = 0; phase < 128; phase++ ) {
+        failed += checkBurst( BERT_PN11, 8000, phase, 0, small );
+        failed += checkBurst( BERT_PN11, 8000, phase, 1, small );
+        // past the first chunk of the pool, and on a chunk boundary
+        failed += checkBurst( BERT_PN11, 8ULL * 3000000, phase, 2, large );
+        failed += checkBurst( BERT_PN11, 8ULL * BERT_PARALLEL_CHUNK * 3 - 64, phase, 2, large );
+        // without a table, in the second bulk block
+        failed += checkBurst( BERT_PN31, 8ULL * 40000, phase, 0, wide );
+        failed += checkSpread( phase );
+        // inside the first two windows after the lock at bit 104
+        failed += checkSlip( 104 + 2 * phase );
+    }
+    failed += checkRates( BERT_PN11 );
+    failed += checkRates( BERT_PN31 );
+    printf( "syncLossTest: %s\n", failed ? "FAILED" : "passed" );
+    return failed ? 1 : 0;
+}